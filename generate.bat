@@ -21,7 +21,8 @@ flatmessage_compiler -e "hpp" -t "E:\Programmieren\C++\Keycap\KeycapEmu\template
 -i "E:\Programmieren\C++\Keycap\KeycapEmu\src\shared\database\schemata\user.scm" ^
 -i "E:\Programmieren\C++\Keycap\KeycapEmu\src\shared\database\schemata\knowledge_base.scm" ^
 -i "E:\Programmieren\C++\Keycap\KeycapEmu\src\shared\database\schemata\character.scm" ^
--i "E:\Programmieren\C++\Keycap\KeycapEmu\src\shared\database\schemata\user_telemetry.scm"
+-i "E:\Programmieren\C++\Keycap\KeycapEmu\src\shared\database\schemata\user_telemetry.scm" ^
+-i "E:\Programmieren\C++\Keycap\KeycapEmu\src\shared\database\schemata\ip_ban.scm"
 echo Done!
 
 echo Building sql schemata...
@@ -32,7 +33,8 @@ flatmessage_compiler -e "sql" -t "E:\Programmieren\C++\Keycap\KeycapEmu\template
 -i "E:\Programmieren\C++\Keycap\KeycapEmu\src\shared\database\schemata\user.scm" ^
 -i "E:\Programmieren\C++\Keycap\KeycapEmu\src\shared\database\schemata\knowledge_base.scm" ^
 -i "E:\Programmieren\C++\Keycap\KeycapEmu\src\shared\database\schemata\character.scm" ^
--i "E:\Programmieren\C++\Keycap\KeycapEmu\src\shared\database\schemata\user_telemetry.scm"
+-i "E:\Programmieren\C++\Keycap\KeycapEmu\src\shared\database\schemata\user_telemetry.scm" ^
+-i "E:\Programmieren\C++\Keycap\KeycapEmu\src\shared\database\schemata\ip_ban.scm"
 echo Done!
 
 echo All Done!
\ No newline at end of file
@@ -78,7 +78,7 @@ keycap::shared::database::database& get_am_database()
 void init_databases(std::vector<std::thread>& thread_pool, config const& config)
 {
     get_am_database().connect(config.database.host, config.database.port, config.database.user,
-                              config.database.password, config.database.schema);
+                              config.database.password, config.database.schema, config.database.threads);
 
     auto& service = get_db_service();
     for (int i = 0; i < config.database.threads; ++i)
@@ -0,0 +1,129 @@
+/*
+    Copyright 2018-2019 KeycapEmu
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "account_batcher.hpp"
+
+#include <database/daos/user.hpp>
+#include <string_utility.hpp>
+
+#include <memory>
+
+extern keycap::shared::database::database& get_login_database();
+
+namespace keycap::accountserver
+{
+    account_batcher::account_batcher(boost::asio::io_service& io_service, account_batch_settings settings)
+      : settings_{settings}
+      , timer_{io_service}
+    {
+    }
+
+    void account_batcher::lookup(std::string const& account_name, user_callback callback)
+    {
+        ++lookups_;
+
+        auto key = shared::to_upper(account_name);
+
+        if (settings_.window.count() <= 0)
+        {
+            ++batches_;
+            batch single;
+            single[key].emplace_back(std::move(callback));
+            return send(std::move(single));
+        }
+
+        std::lock_guard<std::mutex> lock{mutex_};
+
+        bool first = pending_.empty();
+        pending_[key].emplace_back(std::move(callback));
+
+        if (pending_.size() >= settings_.max_size)
+            return flush_locked();
+
+        if (first)
+        {
+            timer_.expires_from_now(boost::posix_time::microseconds{settings_.window.count()});
+            timer_.async_wait([this, generation = generation_](boost::system::error_code const& error) {
+                if (error)
+                    return;
+
+                std::lock_guard<std::mutex> lock{mutex_};
+                if (generation == generation_ && !pending_.empty())
+                    flush_locked();
+            });
+        }
+    }
+
+    void account_batcher::flush_locked()
+    {
+        ++generation_;
+        ++batches_;
+
+        boost::system::error_code ignored;
+        timer_.cancel(ignored);
+
+        batch pending;
+        pending.swap(pending_);
+        send(std::move(pending));
+    }
+
+    void account_batcher::send(batch pending)
+    {
+        std::vector<std::string> names;
+        names.reserve(pending.size());
+        for (auto const& [name, callbacks] : pending)
+            names.emplace_back(name);
+
+        auto shared_pending = std::make_shared<batch>(std::move(pending));
+        auto user_dao = shared::database::dal::get_user_dao(get_login_database());
+        user_dao->users(names, [shared_pending](std::optional<std::vector<shared::database::user>> users) {
+            resolve(std::move(*shared_pending), std::move(users));
+        });
+    }
+
+    void account_batcher::resolve(batch pending, std::optional<std::vector<shared::database::user>> users)
+    {
+        // A failed query doesn't tell whether any of the accounts exist
+        if (!users)
+        {
+            for (auto& [name, callbacks] : pending)
+            {
+                for (auto& callback : callbacks)
+                    callback(std::nullopt, true);
+            }
+            return;
+        }
+
+        for (auto& user : *users)
+        {
+            auto itr = pending.find(shared::to_upper(user.account_name));
+            if (itr == pending.end())
+                continue;
+
+            for (auto& callback : itr->second)
+                callback(user, false);
+
+            pending.erase(itr);
+        }
+
+        // Everything that's left doesn't exist
+        for (auto& [name, callbacks] : pending)
+        {
+            for (auto& callback : callbacks)
+                callback(std::nullopt, false);
+        }
+    }
+}
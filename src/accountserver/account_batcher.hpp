@@ -0,0 +1,91 @@
+/*
+    Copyright 2018-2019 KeycapEmu
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#pragma once
+
+#include <generated/user.hpp>
+
+#include <boost/asio/deadline_timer.hpp>
+#include <boost/asio/io_service.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace keycap::accountserver
+{
+    struct account_batch_settings
+    {
+        // How long the first lookup of a batch waits for others to join it. Zero disables batching
+        std::chrono::microseconds window{1000};
+        // A batch is sent right away once it reaches this many distinct account names
+        size_t max_size = 64;
+    };
+
+    // Collects the account lookups that arrive within a short window and resolves all of them with a single
+    // `WHERE account_name IN (...)` query. Lookups of the same account within a batch share one row.
+    class account_batcher
+    {
+      public:
+        // The user is empty if the account doesn't exist. If it couldn't be looked up at all, failed is set instead
+        using user_callback = std::function<void(std::optional<shared::database::user> user, bool failed)>;
+
+        account_batcher(boost::asio::io_service& io_service, account_batch_settings settings);
+
+        // Looks up the account with the given name and calls the given callback from a database thread
+        void lookup(std::string const& account_name, user_callback callback);
+
+        // Returns the number of queries that have been sent
+        uint64_t batches() const
+        {
+            return batches_;
+        }
+
+        // Returns the number of lookups that have been resolved by those queries
+        uint64_t lookups() const
+        {
+            return lookups_;
+        }
+
+      private:
+        // Keyed by the upper case account name
+        using batch = std::unordered_map<std::string, std::vector<user_callback>>;
+
+        // Sends the pending batch. Requires mutex_ to be locked
+        void flush_locked();
+
+        // Queries all accounts of the given batch and resolves its lookups once they arrive
+        static void send(batch pending);
+
+        static void resolve(batch pending, std::optional<std::vector<shared::database::user>> users);
+
+        account_batch_settings settings_;
+
+        std::mutex mutex_;
+        boost::asio::deadline_timer timer_;
+        batch pending_;
+        // Identifies the pending batch so a late timer doesn't flush the batch after it
+        uint64_t generation_ = 0;
+
+        std::atomic_uint64_t batches_{0};
+        std::atomic_uint64_t lookups_{0};
+    };
+}
@@ -0,0 +1,91 @@
+/*
+    Copyright 2018-2019 KeycapEmu
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "account_invalidations.hpp"
+
+#include <string_utility.hpp>
+
+#include <algorithm>
+
+namespace keycap::accountserver
+{
+    account_invalidations::account_invalidations(size_t history_size)
+      : history_size_{std::max<size_t>(history_size, 1)}
+    {
+    }
+
+    void account_invalidations::invalidate(std::string const& account_name)
+    {
+        auto name = shared::to_upper(account_name);
+
+        std::vector<std::pair<invalidation_callback, reply>> answers;
+        {
+            std::lock_guard<std::mutex> lock{mutex_};
+
+            history_.emplace_back(++sequence_, std::move(name));
+            if (history_.size() > history_size_)
+                history_.pop_front();
+
+            for (auto& [last_sequence, callback] : subscribers_)
+                answers.emplace_back(std::move(callback), make_reply(last_sequence));
+
+            subscribers_.clear();
+        }
+
+        // Answer outside of the lock as the callbacks are likely to subscribe again
+        for (auto& [callback, result] : answers)
+            callback(result.sequence, result.flush_all, result.account_names);
+    }
+
+    void account_invalidations::subscribe(uint64 last_sequence, invalidation_callback callback)
+    {
+        reply result;
+        {
+            std::lock_guard<std::mutex> lock{mutex_};
+
+            if (last_sequence == sequence_)
+            {
+                subscribers_.emplace_back(last_sequence, std::move(callback));
+                return;
+            }
+
+            result = make_reply(last_sequence);
+        }
+
+        callback(result.sequence, result.flush_all, result.account_names);
+    }
+
+    account_invalidations::reply account_invalidations::make_reply(uint64 last_sequence) const
+    {
+        reply result;
+        result.sequence = sequence_;
+
+        // The subscriber is either ahead of us (we've been restarted) or has fallen out of the history
+        result.flush_all =
+            last_sequence > sequence_ || history_.empty() || last_sequence + 1 < history_.front().first;
+
+        if (!result.flush_all)
+        {
+            for (auto const& [sequence, name] : history_)
+            {
+                if (sequence > last_sequence)
+                    result.account_names.emplace_back(name);
+            }
+        }
+
+        return result;
+    }
+}
@@ -0,0 +1,66 @@
+/*
+    Copyright 2018-2019 KeycapEmu
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#pragma once
+
+#include <keycap/root/types.hpp>
+
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace keycap::accountserver
+{
+    // Records which accounts have been changed so services caching account data (i.e. the logonserver) can drop their
+    // copies. Subscribers long-poll: they pass the last sequence number they've seen and are answered as soon as there
+    // is something newer.
+    class account_invalidations
+    {
+      public:
+        // (sequence, flush_all, account names). flush_all is set if the subscriber missed invalidations
+        using invalidation_callback = std::function<void(uint64, bool, std::vector<std::string> const&)>;
+
+        explicit account_invalidations(size_t history_size = 1024);
+
+        // Must be called after an account's verifier, salt, security options or flags have changed or the account has
+        // been created
+        void invalidate(std::string const& account_name);
+
+        // Calls the given callback once there are invalidations newer than the given sequence. The callback is called
+        // right away if there already are
+        void subscribe(uint64 last_sequence, invalidation_callback callback);
+
+      private:
+        struct reply
+        {
+            uint64 sequence = 0;
+            bool flush_all = false;
+            std::vector<std::string> account_names;
+        };
+
+        // Returns everything newer than the given sequence. Requires mutex_ to be held
+        reply make_reply(uint64 last_sequence) const;
+
+        std::mutex mutex_;
+        size_t history_size_;
+        uint64 sequence_ = 0;
+        std::deque<std::pair<uint64, std::string>> history_;
+        std::vector<std::pair<uint64, invalidation_callback>> subscribers_;
+    };
+}
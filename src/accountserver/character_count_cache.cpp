@@ -0,0 +1,105 @@
+/*
+    Copyright 2018-2019 KeycapEmu
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "character_count_cache.hpp"
+
+#include <database/daos/character.hpp>
+
+#include <algorithm>
+
+extern keycap::shared::database::database& get_login_database();
+
+namespace keycap::accountserver
+{
+    character_count_cache::character_count_cache(std::chrono::seconds lifetime)
+      : lifetime_{lifetime}
+    {
+    }
+
+    void character_count_cache::character_counts(uint32 account, counts_callback callback)
+    {
+        {
+            std::lock_guard<std::mutex> lock{mutex_};
+            if (auto itr = accounts_.find(account); itr != accounts_.end())
+            {
+                if (itr->second.expires > std::chrono::steady_clock::now())
+                {
+                    counts result{itr->second.counts.begin(), itr->second.counts.end()};
+                    callback(result);
+                    return;
+                }
+
+                accounts_.erase(itr);
+            }
+        }
+
+        auto character_dao = shared::database::dal::get_character_dao(get_login_database());
+        character_dao->character_counts(account, [this, account, callback](counts loaded) {
+            {
+                std::lock_guard<std::mutex> lock{mutex_};
+
+                auto now = std::chrono::steady_clock::now();
+                if (accounts_.size() >= expire_threshold_)
+                    expire_locked(now);
+
+                // Another request might have loaded the account in the meantime and already applied changes to it
+                auto [itr, inserted] = accounts_.try_emplace(
+                    account, entry{std::unordered_map<uint8, uint8>{loaded.begin(), loaded.end()}, now + lifetime_});
+                if (!inserted)
+                    loaded.assign(itr->second.counts.begin(), itr->second.counts.end());
+            }
+
+            callback(loaded);
+        });
+    }
+
+    void character_count_cache::add_character(uint32 account, uint8 realm)
+    {
+        std::lock_guard<std::mutex> lock{mutex_};
+
+        // Accounts that haven't been loaded yet will pick up the new character from the database
+        if (auto itr = accounts_.find(account); itr != accounts_.end())
+        {
+            auto& count = itr->second.counts[realm];
+            if (count < 255)
+                ++count;
+        }
+    }
+
+    void character_count_cache::remove_character(uint32 account, uint8 realm)
+    {
+        std::lock_guard<std::mutex> lock{mutex_};
+
+        if (auto itr = accounts_.find(account); itr != accounts_.end())
+        {
+            if (auto count = itr->second.counts.find(realm); count != itr->second.counts.end() && count->second > 0)
+                --count->second;
+        }
+    }
+
+    void character_count_cache::expire_locked(std::chrono::steady_clock::time_point now)
+    {
+        for (auto itr = accounts_.begin(); itr != accounts_.end();)
+        {
+            if (itr->second.expires <= now)
+                itr = accounts_.erase(itr);
+            else
+                ++itr;
+        }
+
+        expire_threshold_ = std::max<size_t>(1024, accounts_.size() * 2);
+    }
+}
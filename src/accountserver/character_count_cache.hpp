@@ -0,0 +1,71 @@
+/*
+    Copyright 2018-2019 KeycapEmu
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#pragma once
+
+#include <keycap/root/types.hpp>
+
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace keycap::accountserver
+{
+    // Keeps the number of characters every account has on each realm in memory so the logonserver can fill in the
+    // realm list without hitting the database. Accounts are loaded on first request and kept up to date on character
+    // creation and deletion.
+    // Characters of an account may also be created or deleted through another accountserver once the account moves
+    // to it on the logonservers' ring, so accounts are reloaded once they've been cached for longer than lifetime.
+    class character_count_cache
+    {
+      public:
+        // (realm id, number of characters)
+        using counts = std::vector<std::pair<uint8, uint8>>;
+        using counts_callback = std::function<void(counts const&)>;
+
+        explicit character_count_cache(std::chrono::seconds lifetime);
+
+        // Calls the given callback with the given account's character counts. Will query the database if the account
+        // hasn't been loaded yet, in which case the callback is called from the database thread
+        void character_counts(uint32 account, counts_callback callback);
+
+        // Must be called after a character has been created
+        void add_character(uint32 account, uint8 realm);
+
+        // Must be called after a character has been deleted
+        void remove_character(uint32 account, uint8 realm);
+
+      private:
+        struct entry
+        {
+            std::unordered_map<uint8, uint8> counts;
+            std::chrono::steady_clock::time_point expires;
+        };
+
+        // Drops all accounts that have expired. Requires mutex_ to be locked
+        void expire_locked(std::chrono::steady_clock::time_point now);
+
+        std::chrono::seconds lifetime_;
+
+        std::mutex mutex_;
+        std::unordered_map<uint32, entry> accounts_;
+        // Expired accounts are dropped whenever the cache has grown to twice its size after the last time
+        size_t expire_threshold_ = 1024;
+    };
+}
@@ -16,21 +16,105 @@
 
 #include "character_id_provider.hpp"
 
+#include <database/daos/character.hpp>
+
+#include <keycap/root/utility/utility.hpp>
+
+#include <algorithm>
+#include <chrono>
+
+extern keycap::shared::database::database& get_login_database();
+
 namespace keycap::accountserver
 {
-    character_id_provider::character_id_provider(uint32_t start_id)
-      : character_id_{start_id}
+    // How long character creation waits for a block if the prefetched one hasn't arrived yet
+    constexpr std::chrono::seconds block_timeout{5};
+
+    character_id_provider::character_id_provider(uint32 block_size)
+      : block_size_{std::max(block_size, 1u)}
+    {
+        std::unique_lock<std::mutex> lock{mutex_};
+        if (!next_block(lock))
+        {
+            auto console = keycap::root::utility::get_safe_logger("console");
+            console->error("Couldn't lease a block of character ids. Character creation will retry it");
+        }
+    }
+
+    character_id_provider::~character_id_provider()
+    {
+        std::unique_lock<std::mutex> lock{mutex_};
+        block_arrived_.wait(lock, [this] { return !prefetching_; });
+    }
+
+    std::optional<uint32> character_id_provider::generate_next()
     {
+        auto current = current_.load();
+        while (true)
+        {
+            auto next = static_cast<uint32>(current >> 32);
+            auto end = static_cast<uint32>(current);
+
+            if (next < end)
+            {
+                if (!current_.compare_exchange_weak(current, pack(next + 1, end)))
+                    continue;
+
+                // Retry a prefetch that failed while there's still plenty of time left, so the network thread doesn't
+                // have to wait for the next block once this one is used up
+                if (end - next == block_size_ / 2)
+                {
+                    std::lock_guard<std::mutex> lock{mutex_};
+                    prefetch();
+                }
+
+                return next;
+            }
+
+            std::unique_lock<std::mutex> lock{mutex_};
+
+            // Another thread might have replaced the block while this one waited for the lock
+            if (current_.load() == current && !next_block(lock))
+                return std::nullopt;
+
+            current = current_.load();
+        }
     }
 
-    uint32_t character_id_provider::character_id() const
+    bool character_id_provider::next_block(std::unique_lock<std::mutex>& lock)
     {
-        return character_id_;
+        if (!prefetched_)
+        {
+            prefetch();
+            block_arrived_.wait_for(lock, block_timeout, [this] { return prefetched_ || !prefetching_; });
+        }
+
+        if (!prefetched_)
+            return false;
+
+        current_ = pack(prefetched_->first, prefetched_->end);
+        prefetched_.reset();
+
+        prefetch();
+        return true;
     }
 
-    uint32_t character_id_provider::generate_next()
+    void character_id_provider::prefetch()
     {
-        ++character_id_;
-        return character_id();
+        if (prefetching_ || prefetched_)
+            return;
+
+        prefetching_ = true;
+
+        auto character_dao = shared::database::dal::get_character_dao(get_login_database());
+        character_dao->reserve_ids(block_size_, [this](std::optional<uint32> first) {
+            std::lock_guard<std::mutex> lock{mutex_};
+
+            prefetching_ = false;
+            if (first)
+                prefetched_ = id_block{*first, *first + block_size_};
+
+            block_arrived_.notify_all();
+        });
     }
-}
\ No newline at end of file
+}
@@ -16,19 +16,59 @@
 
 #pragma once
 
+#include <keycap/root/types.hpp>
+
 #include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <optional>
 
 namespace keycap::accountserver
 {
+    // Hands out character ids from blocks that are leased from the id_block table, so several accountservers can
+    // create characters at the same time. Ids are handed out lock-free; the next block is always fetched in the
+    // background while the current one is in use. A failed fetch is retried once half of the current block has been
+    // used. Ids of a block that isn't used up before shutdown are lost.
     class character_id_provider
     {
       public:
-        character_id_provider(uint32_t start_id);
+        // Leases the first block. This will block the thread until it has arrived!
+        explicit character_id_provider(uint32 block_size);
+
+        // Waits for an outstanding prefetch, since it calls back into the provider
+        ~character_id_provider();
 
-        uint32_t character_id() const;
-        uint32_t generate_next();
+        // Returns the next free character id or nothing if no block could be leased
+        std::optional<uint32> generate_next();
 
       private:
-        std::atomic_uint32_t character_id_;
+        struct id_block
+        {
+            uint32 first;
+            uint32 end;
+        };
+
+        // The next id in the upper half and the end of its block in the lower one
+        static uint64_t pack(uint32 next, uint32 end)
+        {
+            return static_cast<uint64_t>(next) << 32 | end;
+        }
+
+        // Replaces the exhausted block with the prefetched one and waits for it if it hasn't arrived yet. Returns false
+        // if there is none. Requires mutex_ to be locked
+        bool next_block(std::unique_lock<std::mutex>& lock);
+
+        // Leases the next block in the background unless it's already there or on its way. Requires mutex_ to be
+        // locked
+        void prefetch();
+
+        uint32 block_size_;
+        std::atomic_uint64_t current_{0};
+
+        std::mutex mutex_;
+        std::condition_variable block_arrived_;
+        std::optional<id_block> prefetched_;
+        bool prefetching_ = false;
     };
-}
\ No newline at end of file
+}
@@ -0,0 +1,108 @@
+/*
+    Copyright 2018-2019 KeycapEmu
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "character_list_cache.hpp"
+
+#include <database/daos/character.hpp>
+
+extern keycap::shared::database::database& get_login_database();
+
+namespace keycap::accountserver
+{
+    character_list_cache::character_list_cache(size_t capacity, std::chrono::seconds lifetime)
+      : capacity_{capacity}
+      , lifetime_{lifetime}
+    {
+    }
+
+    void character_list_cache::realm_characters(uint8 realm, uint32 account, characters_callback callback)
+    {
+        uint64 generation = 0;
+        {
+            std::unique_lock<std::mutex> lock{mutex_};
+            if (auto itr = index_.find(key(account, realm)); itr != index_.end())
+            {
+                if (itr->second->expires <= std::chrono::steady_clock::now())
+                {
+                    lists_.erase(itr->second);
+                    index_.erase(itr);
+                }
+                else
+                {
+                    lists_.splice(lists_.begin(), lists_, itr->second);
+                    characters result = itr->second->list;
+                    lock.unlock();
+
+                    callback(result);
+                    return;
+                }
+            }
+
+            generation = generation_;
+            ++pending_loads_;
+        }
+
+        auto character_dao = shared::database::dal::get_character_dao(get_login_database());
+        auto on_loaded = [this, account, realm, generation, callback](std::optional<characters> loaded) {
+            {
+                std::lock_guard<std::mutex> lock{mutex_};
+
+                // Don't cache a list that couldn't be loaded or has been changed while it was loaded
+                auto itr = invalidations_.find(key(account, realm));
+                if (loaded && (itr == invalidations_.end() || itr->second <= generation))
+                    insert(key(account, realm), *loaded);
+
+                // No outdated load can arrive anymore once none is pending
+                if (--pending_loads_ == 0)
+                    invalidations_.clear();
+            }
+
+            callback(loaded ? *loaded : characters{});
+        };
+
+        character_dao->realm_characters(realm, account, on_loaded);
+    }
+
+    void character_list_cache::invalidate(uint32 account, uint8 realm)
+    {
+        std::lock_guard<std::mutex> lock{mutex_};
+
+        if (auto itr = index_.find(key(account, realm)); itr != index_.end())
+        {
+            lists_.erase(itr->second);
+            index_.erase(itr);
+        }
+
+        ++generation_;
+        if (pending_loads_ > 0)
+            invalidations_[key(account, realm)] = generation_;
+    }
+
+    void character_list_cache::insert(uint64 key, characters const& list)
+    {
+        if (capacity_ == 0 || index_.count(key) > 0)
+            return;
+
+        while (lists_.size() >= capacity_)
+        {
+            index_.erase(lists_.back().key);
+            lists_.pop_back();
+        }
+
+        lists_.push_front(entry{key, list, std::chrono::steady_clock::now() + lifetime_});
+        index_.emplace(key, lists_.begin());
+    }
+}
@@ -0,0 +1,85 @@
+/*
+    Copyright 2018-2019 KeycapEmu
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#pragma once
+
+#include <generated/character.hpp>
+
+#include <keycap/root/types.hpp>
+
+#include <chrono>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+namespace keycap::accountserver
+{
+    // Keeps the character list of every account on each realm in memory, since it's requested on every realm entry
+    // and every return to the character screen. Lists are loaded on first request and dropped on character creation
+    // and deletion. Once full, the least recently used list is evicted.
+    // Just like character_count_cache, lists are reloaded after lifetime as their characters may also be changed
+    // through another accountserver.
+    class character_list_cache
+    {
+      public:
+        using characters = std::vector<shared::database::character>;
+        using characters_callback = std::function<void(characters const&)>;
+
+        // Keeps at most capacity lists in memory, each for at most lifetime
+        character_list_cache(size_t capacity, std::chrono::seconds lifetime);
+
+        // Calls the given callback with the given account's characters on the given realm. Will query the database if
+        // the list hasn't been loaded yet, in which case the callback is called from the database thread. A list that
+        // couldn't be loaded is passed on as empty but isn't cached
+        void realm_characters(uint8 realm, uint32 account, characters_callback callback);
+
+        // Must be called after a character of the given account has been created or deleted on the given realm
+        void invalidate(uint32 account, uint8 realm);
+
+      private:
+        static uint64 key(uint32 account, uint8 realm)
+        {
+            return static_cast<uint64>(account) << 8 | realm;
+        }
+
+        struct entry
+        {
+            uint64 key;
+            characters list;
+            std::chrono::steady_clock::time_point expires;
+        };
+
+        // Caches the given list, evicting the least recently used one if full. Requires mutex_ to be held
+        void insert(uint64 key, characters const& list);
+
+        size_t capacity_;
+        std::chrono::seconds lifetime_;
+
+        std::mutex mutex_;
+        // Most recently used first
+        std::list<entry> lists_;
+        std::unordered_map<uint64, std::list<entry>::iterator> index_;
+
+        // The generation in which each list has been invalidated last. A load that started before that is outdated.
+        // Only needed while loads are pending, so it's cleared whenever the last one finishes
+        std::unordered_map<uint64, uint64> invalidations_;
+        uint64 generation_ = 0;
+        size_t pending_loads_ = 0;
+    };
+}
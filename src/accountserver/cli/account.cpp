@@ -14,7 +14,10 @@
     limitations under the License.
 */
 
+#include "../account_invalidations.hpp"
+
 #include <cli/command.hpp>
+#include <cryptography/random.hpp>
 
 #include <database/daos/user.hpp>
 
@@ -22,18 +25,19 @@
 #include <generated/permissions.hpp>
 #include <generated/user.hpp>
 #include <rbac/role.hpp>
+#include <string_utility.hpp>
 
 #include <keycap/root/network/srp6/server.hpp>
 #include <keycap/root/network/srp6/utility.hpp>
 #include <keycap/root/utility/meta.hpp>
 
-#include <botan/auto_rng.h>
 #include <botan/bigint.h>
 #include <botan/numthry.h>
 #include <botan/sha160.h>
 
 #include <spdlog/fmt/fmt.h>
 
+#include <algorithm>
 #include <iostream>
 
 namespace db = keycap::shared::database;
@@ -41,23 +45,16 @@ namespace net = keycap::root::network;
 namespace rbac = keycap::shared::rbac;
 
 extern keycap::shared::database::database& get_login_database();
+extern keycap::accountserver::account_invalidations& get_account_invalidations();
 
 namespace keycap::accountserver::cli
 {
-    bool create_command(std::vector<std::string> const& args, rbac::role const& role)
+    void create_account(std::string const& username, std::string const& password, std::string const& email)
     {
-        constexpr auto requiredArguments = 3;
-        if (args.empty() || args.size() < requiredArguments)
-            return false;
-
-        auto username = args[0];
-        auto password = args[1];
-        auto email = args[2];
-
         constexpr auto compliance = net::srp6::compliance::Wow;
         auto parameter = net::srp6::get_parameters(net::srp6::group_parameters::_256);
 
-        auto rnd_salt = Botan::AutoSeeded_RNG().random_vec(32);
+        auto rnd_salt = shared::cryptography::random_bytes(32);
         Botan::BigInt salt = Botan::BigInt::decode({rnd_salt});
         auto v = Botan::BigInt::encode(net::srp6::generate_verifier(username, password, parameter, salt, compliance));
 
@@ -67,9 +64,54 @@ namespace keycap::accountserver::cli
         auto dao = db::dal::get_user_dao(get_login_database());
         dao->user(username, [=](std::optional<keycap::shared::database::user> user) {
             auto dao = db::dal::get_user_dao(get_login_database());
-            if (!user)
-                dao->create(db::user{0, username, email, 0, 0, hex_v, hex_salt});
+            if (user)
+                return;
+
+            dao->create(db::user{0, username, email, 0, 0, hex_v, hex_salt});
+
+            // The logonserver might have cached that this account doesn't exist
+            get_account_invalidations().invalidate(username);
         });
+    }
+
+    bool create_command(std::vector<std::string> const& args, rbac::role const& role)
+    {
+        constexpr auto requiredArguments = 3;
+        if (args.empty() || args.size() < requiredArguments)
+            return false;
+
+        create_account(args[0], args[1], args[2]);
+
+        return true;
+    }
+
+    // Creates <count> accounts named <prefix><index> that all share the same password. Used by the login load generator
+    bool seed_command(std::vector<std::string> const& args, rbac::role const& role)
+    {
+        constexpr auto requiredArguments = 3;
+        if (args.empty() || args.size() < requiredArguments)
+            return false;
+
+        auto prefix = keycap::shared::to_upper(args[0]);
+        auto password = args[2];
+
+        unsigned long count = 0;
+        try
+        {
+            count = std::stoul(args[1]);
+        }
+        catch (std::exception const&)
+        {
+            return false;
+        }
+
+        for (unsigned long i = 0; i < count; ++i)
+        {
+            auto username = fmt::format("{}{}", prefix, i);
+            create_account(username, password, fmt::format("{}@localhost", username));
+        }
+
+        std::cout << fmt::format("Seeding {} accounts {}0 - {}{}\n", count, prefix, prefix, count ? count - 1 : 0);
 
         return true;
     }
@@ -82,6 +124,8 @@ namespace keycap::accountserver::cli
         std::vector<keycap::shared::cli::command> commands = {
             keycap::shared::cli::command{"create", permission::CommandAccountCreate, create_command,
                                          "Creates a new account. Arguments: username, password, email"s},
+            keycap::shared::cli::command{"seed", permission::CommandAccountSeed, seed_command,
+                                         "Creates <count> test accounts. Arguments: prefix, count, password"s},
         };
 
         return keycap::shared::cli::command{"account"s, permission::CommandAccount, nullptr,
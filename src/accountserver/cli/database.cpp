@@ -0,0 +1,73 @@
+/*
+    Copyright 2018-2019 KeycapEmu
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "../account_batcher.hpp"
+#include "../telemetry_sink.hpp"
+
+#include <cli/command.hpp>
+#include <database/database.hpp>
+#include <generated/permissions.hpp>
+#include <rbac/role.hpp>
+
+#include <spdlog/fmt/fmt.h>
+
+#include <iostream>
+
+namespace rbac = keycap::shared::rbac;
+
+extern keycap::shared::database::database& get_login_database();
+extern keycap::accountserver::account_batcher& get_account_batcher();
+extern keycap::accountserver::telemetry_sink& get_telemetry_sink();
+
+namespace keycap::accountserver::cli
+{
+    bool database_command(std::vector<std::string> const& args, rbac::role const& role)
+    {
+        auto& batcher = get_account_batcher();
+        std::cout << fmt::format("Account lookups: {} in {} queries\n", batcher.lookups(), batcher.batches());
+
+        auto& telemetry = get_telemetry_sink();
+        std::cout << fmt::format("Telemetry: {} written {} dropped {} failed\n", telemetry.written(),
+                                 telemetry.dropped(), telemetry.failed());
+
+        auto& database = get_login_database();
+        if (database.backend() == shared::database::database_backend::memory)
+        {
+            auto& store = database.memory_store();
+            std::cout << fmt::format("In-memory backend with {} user(s) and {} character(s)\n", store.users.size(),
+                                     store.characters.size());
+            return true;
+        }
+
+        for (auto const& stats : database.stats())
+        {
+            std::cout << fmt::format("Connection {}: {} executions: {} failures: {} reconnects: {} busy: {:.1f}%\n",
+                                     stats.index, stats.connected ? "up" : "down", stats.executions, stats.failures,
+                                     stats.reconnects, stats.utilization * 100.0);
+        }
+
+        return true;
+    }
+
+    keycap::shared::cli::command register_database()
+    {
+        using keycap::shared::permission;
+        using namespace std::string_literals;
+
+        return keycap::shared::cli::command{"database"s, permission::CommandDatabase, &database_command,
+                                            "Displays the utilization of the pooled database connections"s};
+    }
+}
@@ -23,6 +23,7 @@ namespace keycap::accountserver::cli
     namespace cli = keycap::shared::cli;
     extern cli::command register_help();
     extern cli::command register_account();
+    extern cli::command register_database();
 
     namespace impl
     {
@@ -36,5 +37,6 @@ namespace keycap::accountserver::cli
     {
         impl::register_command(register_help(), command_map);
         impl::register_command(register_account(), command_map);
+        impl::register_command(register_database(), command_map);
     }
 }
\ No newline at end of file
@@ -14,9 +14,14 @@
     limitations under the License.
 */
 
+#include "account_batcher.hpp"
+#include "account_invalidations.hpp"
+#include "character_count_cache.hpp"
 #include "character_id_provider.hpp"
+#include "character_list_cache.hpp"
 #include "cli/registrar.hpp"
 #include "network/connection.hpp"
+#include "telemetry_sink.hpp"
 
 #include <cli/helpers.hpp>
 #include <crash_dump.hpp>
@@ -32,6 +37,8 @@
 
 #include <spdlog/spdlog.h>
 
+#include <optional>
+
 namespace logging = keycap::shared::logging;
 
 struct config
@@ -53,7 +60,31 @@ struct config
         std::string password;
         std::string schema;
         int threads;
+        // "MySQL" or "Memory"
+        std::string backend;
     } database;
+
+    // The realm the in-memory backend starts with, since there is no realm table to read it from
+    struct
+    {
+        int id;
+        std::string name;
+        std::string host;
+        uint16_t port;
+    } memory_realm;
+
+    // Number of character ids that are leased from the database at once
+    uint32_t character_id_block_size;
+
+    // Number of character lists that are kept in memory
+    size_t character_list_cache_size;
+
+    // How long character counts and lists are cached before they're reloaded
+    std::chrono::seconds character_cache_lifetime;
+
+    keycap::accountserver::account_batch_settings account_batch;
+
+    keycap::accountserver::telemetry_settings telemetry;
 };
 
 config parse_config(std::string configFile)
@@ -73,6 +104,27 @@ config parse_config(std::string configFile)
     conf.database.password = cfg_file.get_or_default<std::string>("Database", "Password", "");
     conf.database.schema = cfg_file.get_or_default<std::string>("Database", "Schema", "");
     conf.database.threads = cfg_file.get_or_default<int>("Database", "Threads", 1);
+    conf.database.backend = cfg_file.get_or_default<std::string>("Database", "Backend", "MySQL");
+
+    conf.character_id_block_size = cfg_file.get_or_default<uint32_t>("Characters", "IdBlockSize", 1000);
+    conf.character_list_cache_size = cfg_file.get_or_default<size_t>("Characters", "ListCacheSize", 10000);
+    conf.character_cache_lifetime
+        = std::chrono::seconds{cfg_file.get_or_default<int>("Characters", "CacheLifetimeSeconds", 300)};
+
+    conf.account_batch.window = std::chrono::microseconds{
+        cfg_file.get_or_default<int>("AccountBatch", "WindowMicroseconds", 1000)};
+    conf.account_batch.max_size = cfg_file.get_or_default<size_t>("AccountBatch", "MaxSize", 64);
+
+    conf.telemetry.capacity = cfg_file.get_or_default<size_t>("Telemetry", "BufferSize", 4096);
+    conf.telemetry.batch_size = cfg_file.get_or_default<size_t>("Telemetry", "BatchSize", 256);
+    conf.telemetry.flush_interval = std::chrono::milliseconds{
+        cfg_file.get_or_default<int>("Telemetry", "FlushIntervalMilliseconds", 1000)};
+    conf.telemetry.compression_level = cfg_file.get_or_default<int>("Telemetry", "CompressionLevel", 6);
+
+    conf.memory_realm.id = cfg_file.get_or_default<int>("MemoryRealm", "Id", 1);
+    conf.memory_realm.name = cfg_file.get_or_default<std::string>("MemoryRealm", "Name", "KeycapEmu");
+    conf.memory_realm.host = cfg_file.get_or_default<std::string>("MemoryRealm", "Host", "127.0.0.1");
+    conf.memory_realm.port = cfg_file.get_or_default<uint16_t>("MemoryRealm", "Port", 8085);
 
     return conf;
 }
@@ -91,17 +143,37 @@ keycap::shared::database::database& get_login_database()
 
 void init_databases(std::vector<std::thread>& thread_pool, config const& config)
 {
-    get_login_database().connect(config.database.host, config.database.port, config.database.user,
-                                 config.database.password, config.database.schema);
+    if (config.database.backend == "Memory")
+    {
+        auto& database = get_login_database();
+        database.open_memory();
+
+        keycap::shared::database::realm realm{};
+        realm.id = static_cast<uint8>(config.memory_realm.id);
+        realm.name = config.memory_realm.name;
+        realm.host = config.memory_realm.host;
+        realm.port = config.memory_realm.port;
+        database.memory_store().realms.insert(realm.id, realm);
+
+        auto console = keycap::root::utility::get_safe_logger("console");
+        console->warn("Using the in-memory database backend. Nothing will be persisted");
+    }
+    else
+    {
+        get_login_database().connect(config.database.host, config.database.port, config.database.user,
+                                     config.database.password, config.database.schema, config.database.threads);
+    }
 
     auto& service = get_db_service();
     for (int i = 0; i < config.database.threads; ++i)
         thread_pool.emplace_back([&] { service.run(); });
 }
 
-void kill_databases(std::vector<std::thread>& thread_pool)
+void kill_databases(std::vector<std::thread>& thread_pool, std::optional<boost::asio::io_service::work>& work)
 {
-    get_db_service().stop();
+    // Instead of stopping the service right away, the threads finish whatever has been queued, like the telemetry
+    // sink's final flush, and return once there's nothing left
+    work.reset();
     for (auto& thread : thread_pool)
     {
         if (thread.joinable())
@@ -109,6 +181,26 @@ void kill_databases(std::vector<std::thread>& thread_pool)
     }
 }
 
+keycap::accountserver::account_invalidations& get_account_invalidations()
+{
+    static keycap::accountserver::account_invalidations account_invalidations;
+    return account_invalidations;
+}
+
+std::unique_ptr<keycap::accountserver::account_batcher> account_batcher;
+
+keycap::accountserver::account_batcher& get_account_batcher()
+{
+    return *account_batcher;
+}
+
+std::unique_ptr<keycap::accountserver::telemetry_sink> telemetry_sink;
+
+keycap::accountserver::telemetry_sink& get_telemetry_sink()
+{
+    return *telemetry_sink;
+}
+
 keycap::shared::cli::command_map commands;
 
 auto& get_command_map()
@@ -140,10 +232,10 @@ int main()
     console->info("Listening to {} on port {} with {} thread(s).", config.network.bind_ip, config.network.port,
                   config.network.threads);
 
-    boost::asio::io_service::work db_work{get_db_service()};
+    std::optional<boost::asio::io_service::work> db_work{std::in_place, get_db_service()};
     std::vector<std::thread> db_thread_pool;
     init_databases(db_thread_pool, config);
-    SCOPE_EXIT(sc2, [&] { kill_databases(db_thread_pool); });
+    SCOPE_EXIT(sc2, [&] { kill_databases(db_thread_pool, db_work); });
 
     bool running = true;
     keycap::accountserver::cli::register_commands(commands);
@@ -159,11 +251,25 @@ int main()
                              },
                              "Shuts down the Server"s});
 
-    auto character_dao = keycap::shared::database::dal::get_character_dao(get_login_database());
+    keycap::accountserver::character_id_provider character_id_provider{config.character_id_block_size};
+
+    keycap::accountserver::character_count_cache character_count_cache{config.character_cache_lifetime};
+    keycap::accountserver::character_list_cache character_list_cache{config.character_list_cache_size,
+                                                                     config.character_cache_lifetime};
+
+    // Runs its timer on the database threads, the lookups end up there anyway
+    account_batcher = std::make_unique<keycap::accountserver::account_batcher>(get_db_service(), config.account_batch);
+    QUICK_SCOPE_EXIT(ab, [] { account_batcher.reset(); });
 
-    keycap::accountserver::character_id_provider character_id_provider{character_dao->last_id()};
+    // Flushes whatever is still buffered when it goes out of scope. kill_databases lets that flush finish
+    telemetry_sink = std::make_unique<keycap::accountserver::telemetry_sink>(get_db_service(), *account_batcher,
+                                                                             config.telemetry);
+    QUICK_SCOPE_EXIT(ts, [] { telemetry_sink.reset(); });
 
-    keycap::accountserver::account_service service{config.network.threads, character_id_provider};
+    keycap::accountserver::account_service service{config.network.threads, character_id_provider,
+                                                   character_count_cache, character_list_cache,
+                                                   get_account_invalidations(),
+                                                   *account_batcher, *telemetry_sink};
     service.start(config.network.bind_ip, config.network.port);
 
     keycap::shared::cli::run_command_line(
@@ -23,23 +23,44 @@
 namespace keycap::accountserver
 {
     class connection;
+    class account_batcher;
+    class account_invalidations;
     class character_id_provider;
+    class character_count_cache;
+    class character_list_cache;
+    class telemetry_sink;
 
     class account_service : public keycap::root::network::service<connection>
     {
       public:
-        explicit account_service(int thread_count, character_id_provider& character_id_provider)
+        explicit account_service(int thread_count, character_id_provider& character_id_provider,
+                                 character_count_cache& character_count_cache,
+                                 character_list_cache& character_list_cache,
+                                 account_invalidations& account_invalidations, account_batcher& account_batcher,
+                                 telemetry_sink& telemetry_sink)
           : service{keycap::root::network::service_mode::Server, shared::network::account_service_type, thread_count}
           , character_id_provider_{character_id_provider}
+          , character_count_cache_{character_count_cache}
+          , character_list_cache_{character_list_cache}
+          , account_invalidations_{account_invalidations}
+          , account_batcher_{account_batcher}
+          , telemetry_sink_{telemetry_sink}
         {
         }
 
       protected:
         virtual SharedHandler make_handler(boost::asio::ip::tcp::socket socket) override
         {
-            return std::make_shared<connection>(std::move(socket), *this, character_id_provider_);
+            return std::make_shared<connection>(std::move(socket), *this, character_id_provider_,
+                                                character_count_cache_, character_list_cache_, account_invalidations_,
+                                                account_batcher_, telemetry_sink_);
         }
 
         character_id_provider& character_id_provider_;
+        character_count_cache& character_count_cache_;
+        character_list_cache& character_list_cache_;
+        account_invalidations& account_invalidations_;
+        account_batcher& account_batcher_;
+        telemetry_sink& telemetry_sink_;
     };
 }
\ No newline at end of file
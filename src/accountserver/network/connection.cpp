@@ -15,17 +15,24 @@
 */
 
 #include "connection.hpp"
+#include "../account_batcher.hpp"
+#include "../account_invalidations.hpp"
+#include "../character_count_cache.hpp"
 #include "../character_id_provider.hpp"
+#include "../character_list_cache.hpp"
+#include "../telemetry_sink.hpp"
 
 #include <generated/shared_protocol.hpp>
 
 #include <database/daos/character.hpp>
+#include <database/daos/ip_ban.hpp>
 #include <database/daos/realm.hpp>
 #include <database/daos/user.hpp>
-#include <database/daos/user_telemetry.hpp>
 
 #include <spdlog/spdlog.h>
 
+#include <stdexcept>
+
 namespace net = keycap::root::network;
 namespace shared_net = keycap::shared::network;
 namespace protocol = keycap::protocol;
@@ -35,9 +42,17 @@ extern keycap::shared::database::database& get_login_database();
 namespace keycap::accountserver
 {
     connection::connection(boost::asio::ip::tcp::socket socket, net::service_base& service,
-                           character_id_provider& character_id_provider)
+                           character_id_provider& character_id_provider, character_count_cache& character_count_cache,
+                           character_list_cache& character_list_cache, account_invalidations& account_invalidations,
+                           account_batcher& account_batcher, telemetry_sink& telemetry_sink)
       : net::service_connection{std::move(socket), service}
       , character_id_provider_{character_id_provider}
+      , character_count_cache_{character_count_cache}
+      , character_list_cache_{character_list_cache}
+      , account_invalidations_{account_invalidations}
+      , account_batcher_{account_batcher}
+      , telemetry_sink_{telemetry_sink}
+      , logger_{keycap::root::utility::get_safe_logger("connections")}
     {
         router_.configure_inbound(this);
     }
@@ -45,11 +60,13 @@ namespace keycap::accountserver
     bool connection::on_data(net::data_router const& router, net::service_type service, uint64 sender,
                              net::memory_stream& stream)
     {
+        if (self_.expired())
+            self_ = std::static_pointer_cast<connection>(shared_from_this());
+
         // clang-format off
-        return std::visit([&](auto state)
+        return std::visit([&](auto& state)
         {
-            auto logger = keycap::root::utility::get_safe_logger("connections");
-            logger->debug("[connection] Received data in state: {}", state.name);
+            logger_->debug("[connection] Received data in state: {}", state.name);
 
             try
             {
@@ -57,7 +74,7 @@ namespace keycap::accountserver
             }
             catch (std::exception const& e)
             {
-                logger->error(e.what());
+                logger_->error(e.what());
                 return false;
             }
             catch (...)
@@ -74,14 +91,12 @@ namespace keycap::accountserver
     {
         if (status == net::link_status::Up)
         {
-            auto logger = keycap::root::utility::get_safe_logger("connections");
-            logger->debug("[connection] New connection");
+            logger_->debug("[connection] New connection");
             state_ = connected{};
         }
         else
         {
-            auto logger = keycap::root::utility::get_safe_logger("connections");
-            logger->debug("[connection] Connection closed");
+            logger_->debug("[connection] Connection closed");
             state_ = disconnected{};
         }
 
@@ -91,88 +106,106 @@ namespace keycap::accountserver
     shared::network::state_result connection::disconnected::on_data(connection& connection, uint64 sender,
                                                                     net::memory_stream& stream)
     {
-        auto logger = keycap::root::utility::get_safe_logger("connections");
-        logger->error("[connection] defuq???");
+        connection.logger_->error("[connection] defuq???");
         return shared::network::state_result::abort;
     }
 
+    // Only handlers with exactly this signature can be added to the dispatch table
+    template <typename HANDLER>
+    struct handler_traits;
+
+    template <typename STATE, typename PACKET>
+    struct handler_traits<shared::network::state_result (STATE::*)(std::weak_ptr<accountserver::connection>&, uint64,
+                                                                   PACKET&)>
+    {
+        using packet = PACKET;
+    };
+
+    template <auto HANDLER>
+    shared::network::state_result
+    connection::connected::dispatch(connected& state, std::weak_ptr<accountserver::connection>& connection_ptr,
+                                    uint64 sender, net::memory_stream& stream)
+    {
+        auto packet = handler_traits<decltype(HANDLER)>::packet::decode(stream);
+        return (state.*HANDLER)(connection_ptr, sender, packet);
+    }
+
+    template <auto HANDLER>
+    constexpr std::pair<size_t, connection::connected::handler> connection::connected::entry()
+    {
+        using packet = typename handler_traits<decltype(HANDLER)>::packet;
+        return {static_cast<size_t>(packet::message_command), &dispatch<HANDLER>};
+    }
+
+    constexpr std::array<connection::connected::handler, 256> connection::connected::handlers = [] {
+        std::array<handler, 256> table{};
+
+        for (auto [command, handler] : {
+                 entry<&connected::on_account_data_request>(),
+                 entry<&connected::on_update_session_key>(),
+                 entry<&connected::on_session_key_request>(),
+                 entry<&connected::on_realm_data_request>(),
+                 entry<&connected::on_characters_request>(),
+                 entry<&connected::on_request_account_id_from_name>(),
+                 entry<&connected::on_login_telemetry>(),
+                 entry<&connected::on_char_create>(),
+                 entry<&connected::on_char_delete>(),
+                 entry<&connected::on_character_counts_request>(),
+                 entry<&connected::on_subscribe_account_invalidations>(),
+                 entry<&connected::on_ip_bans_request>(),
+             })
+        {
+            // Fails to compile if two handlers expect the same command
+            if (table[command] != nullptr)
+                throw std::logic_error("Duplicate handler for a shared_command");
+
+            table[command] = handler;
+        }
+
+        return table;
+    }();
+
     shared::network::state_result connection::connected::on_data(connection& connection, uint64 sender,
                                                                  net::memory_stream& stream)
     {
         auto command = stream.peek<protocol::shared_command>();
-        auto logger = keycap::root::utility::get_safe_logger("connections");
-
-        std::weak_ptr<accountserver::connection> connection_ptr{
-            std::static_pointer_cast<accountserver::connection>(connection.shared_from_this())};
 
-        logger->debug("[connection] Received {} from {}", command.to_string(), sender);
+        if (connection.logger_->should_log(spdlog::level::debug))
+            connection.logger_->debug("[connection] Received {} from {}", command.to_string(), sender);
 
-        switch (command)
+        auto handler = handlers[static_cast<uint8>(command)];
+        if (!handler)
         {
-            default:
-            {
-                logger->error("[connection] Received unkown command {}", command);
-                return shared::network::state_result::abort;
-            }
-            case protocol::shared_command::request_account_data:
-            {
-                auto packet = protocol::request_account_data::decode(stream);
-                return on_account_data_request(connection_ptr, sender, packet);
-            }
-            case protocol::shared_command::update_session_key:
-            {
-                auto packet = protocol::update_session_key::decode(stream);
-                return on_update_session_key(connection_ptr, sender, packet);
-            }
-            case protocol::shared_command::request_session_key:
-            {
-                auto packet = protocol::request_session_key::decode(stream);
-                return on_session_key_request(connection_ptr, sender, packet);
-            }
-            case protocol::shared_command::request_realm_data:
-            {
-                auto packet = protocol::request_realm_data::decode(stream);
-                return on_realm_data_request(connection_ptr, sender, packet);
-            }
-            case protocol::shared_command::request_characters:
-            {
-                auto packet = protocol::request_characters::decode(stream);
-                return on_characters_request(connection_ptr, sender, packet);
-            }
-            case protocol::shared_command::request_account_id_from_name:
-            {
-                auto packet = protocol::request_account_id_from_name::decode(stream);
-                return on_request_account_id_from_name(connection_ptr, sender, packet);
-            }
-            case protocol::shared_command::login_telemetry:
-            {
-                auto packet = protocol::login_telemetry::decode(stream);
-                return on_login_telemetry(connection_ptr, sender, packet);
-            }
-            case protocol::shared_command::char_create:
-            {
-                auto packet = protocol::char_create::decode(stream);
-                return on_char_create(connection_ptr, sender, packet);
-            }
+            connection.logger_->error("[connection] Received unkown command {}", command);
+            return shared::network::state_result::abort;
         }
+
+        return handler(*this, connection.self_, sender, stream);
     }
 
     shared::network::state_result
     connection::connected::on_account_data_request(std::weak_ptr<accountserver::connection>& connection_ptr,
                                                    uint64 sender, protocol::request_account_data& packet)
     {
-        auto user_dao = shared::database::dal::get_user_dao(get_login_database());
-        user_dao->user(packet.account_name, [sender,
-                                             connection = connection_ptr](std::optional<shared::database::user> user) {
+        auto& account_batcher = connection_ptr.lock()->account_batcher_;
+        account_batcher.lookup(packet.account_name, [sender, connection = connection_ptr](
+                                                        std::optional<shared::database::user> user, bool failed) {
             if (connection.expired())
                 return;
 
+            auto conn = connection.lock();
             protocol::reply_account_data reply;
+            reply.failed = failed;
 
             if (user)
-                reply.data = protocol::account_data{user->verifier, user->salt, user->security_options, user->flags};
+            {
+                // The client sends its telemetry right after this, so it doesn't need to look the account up again
+                conn->telemetry_sink_.remember(user->account_name, user->id);
+                reply.data = protocol::account_data{user->id, user->verifier, user->salt, user->security_options,
+                                                    user->flags};
+            }
 
-            connection.lock()->send_answer(sender, reply.encode());
+            conn->send_answer(sender, reply.encode());
         });
 
         return shared::network::state_result::ok;
@@ -192,17 +225,23 @@ namespace keycap::accountserver
     connection::connected::on_session_key_request(std::weak_ptr<accountserver::connection>& connection_ptr,
                                                   uint64 sender, protocol::request_session_key& packet)
     {
-        auto user_dao = shared::database::dal::get_user_dao(get_login_database());
-        user_dao->user(packet.account_name,
-                       [sender, connection = connection_ptr](std::optional<shared::database::user> user) {
-                           if (connection.expired() || !user)
-                               return;
-
-                           protocol::reply_session_key reply;
-                           reply.session_key = user->session_key;
-
-                           connection.lock()->send_answer(sender, reply.encode());
-                       });
+        auto& account_batcher = connection_ptr.lock()->account_batcher_;
+        account_batcher.lookup(packet.account_name,
+                               [sender, connection = connection_ptr](std::optional<shared::database::user> user,
+                                                                     bool failed) {
+                                   if (connection.expired())
+                                       return;
+
+                                   // Always answer so the requester doesn't have to wait for a reply that never comes
+                                   protocol::reply_session_key reply;
+                                   if (user && !user->session_key.empty())
+                                   {
+                                       reply.session_key = user->session_key;
+                                       reply.account_id = user->id;
+                                   }
+
+                                   connection.lock()->send_answer(sender, reply.encode());
+                               });
 
         return shared::network::state_result::ok;
     }
@@ -222,7 +261,8 @@ namespace keycap::accountserver
                              reply.info = {static_cast<protocol::realm_type>(realm->type),         realm->locked,
                                            static_cast<protocol::realm_flag>(realm->flags),        realm->name,
                                            fmt::format("{}:{}", realm->host, realm->port),         realm->population,
-                                           static_cast<protocol::realm_category>(realm->category), realm->id};
+                                           static_cast<protocol::realm_category>(realm->category), realm->id,
+                                           realm->allowed_build ? realm->allowed_build->build : uint16{0}};
 
                              connection.lock()->send_answer(sender, reply.encode());
                          });
@@ -234,17 +274,17 @@ namespace keycap::accountserver
     connection::connected::on_characters_request(std::weak_ptr<accountserver::connection>& connection_ptr,
                                                  uint64 sender, protocol::request_characters& packet)
     {
-        auto char_dao = shared::database::dal::get_character_dao(get_login_database());
+        auto& character_list_cache = connection_ptr.lock()->character_list_cache_;
 
-        char_dao->realm_characters(
+        character_list_cache.realm_characters(
             packet.realm_id, packet.account_id,
-            [sender, connection = connection_ptr](std::vector<shared::database::character> characters) {
+            [sender, connection = connection_ptr](std::vector<shared::database::character> const& characters) {
                 if (connection.expired())
                     return;
 
                 protocol::reply_characters reply;
 
-                for (auto& character : characters)
+                for (auto const& character : characters)
                 {
                     reply.characters.emplace_back(protocol::char_data{
                         character.id,         character.name,        character.race,        character.player_class,
@@ -286,8 +326,7 @@ namespace keycap::accountserver
     connection::connected::on_login_telemetry(std::weak_ptr<accountserver::connection>& connection_ptr, uint64 sender,
                                               protocol::login_telemetry& packet)
     {
-        auto telemetry_dao = shared::database::dal::get_user_telemetry_dao(get_login_database());
-        telemetry_dao->add_telemetry_data(packet.account_name, packet.telemetry);
+        connection_ptr.lock()->telemetry_sink_.submit(packet.account_name, std::move(packet.telemetry));
 
         return shared::network::state_result::ok;
     }
@@ -298,7 +337,18 @@ namespace keycap::accountserver
     {
         auto character_dao = shared::database::dal::get_character_dao(get_login_database());
 
-        auto callback = [sender, connection = connection_ptr](keycap::protocol::char_create_result result) {
+        auto conn = connection_ptr.lock();
+
+        // The caches outlive the connection and have to be updated even if it's gone by the time the result arrives
+        auto callback = [sender, connection = connection_ptr, account = packet.account_id, realm = packet.realm_id,
+                         &count_cache = conn->character_count_cache_, &list_cache = conn->character_list_cache_](
+                            keycap::protocol::char_create_result result) {
+            if (result == keycap::protocol::char_create_result::success)
+            {
+                count_cache.add_character(account, realm);
+                list_cache.invalidate(account, realm);
+            }
+
             if (connection.expired())
                 return;
 
@@ -308,8 +358,111 @@ namespace keycap::accountserver
             connection.lock()->send_answer(sender, reply.encode());
         };
 
-        auto char_id = (*connection_ptr.lock()).character_id_provider_.generate_next();
-        character_dao->create_character(packet.realm_id, char_id, packet.account_id, packet.data, callback);
+        auto char_id = conn->character_id_provider_.generate_next();
+        if (!char_id)
+        {
+            callback(keycap::protocol::char_create_result::error);
+            return shared::network::state_result::ok;
+        }
+
+        character_dao->create_character(packet.realm_id, *char_id, packet.account_id, packet.data, callback);
+
+        return shared::network::state_result::ok;
+    }
+
+    shared::network::state_result
+    connection::connected::on_char_delete(std::weak_ptr<accountserver::connection>& connection_ptr, uint64 sender,
+                                          protocol::char_delete& packet)
+    {
+        auto character_dao = shared::database::dal::get_character_dao(get_login_database());
+
+        auto conn = connection_ptr.lock();
+
+        // Same as for on_char_create, the caches are updated even if the connection is gone
+        auto callback = [sender, connection = connection_ptr, account = packet.account_id, realm = packet.realm_id,
+                         &count_cache = conn->character_count_cache_,
+                         &list_cache = conn->character_list_cache_](bool success) {
+            if (success)
+            {
+                count_cache.remove_character(account, realm);
+                list_cache.invalidate(account, realm);
+            }
+
+            if (connection.expired())
+                return;
+
+            protocol::reply_char_delete reply;
+            reply.result = success ? protocol::char_delete_result::success : protocol::char_delete_result::failed;
+
+            connection.lock()->send_answer(sender, reply.encode());
+        };
+
+        character_dao->delete_realm_character(packet.realm_id, packet.account_id, packet.character_id, callback);
+
+        return shared::network::state_result::ok;
+    }
+
+    shared::network::state_result
+    connection::connected::on_character_counts_request(std::weak_ptr<accountserver::connection>& connection_ptr,
+                                                       uint64 sender, protocol::request_character_counts& packet)
+    {
+        auto conn = connection_ptr.lock();
+
+        conn->character_count_cache_.character_counts(
+            packet.account_id, [sender, connection = connection_ptr](character_count_cache::counts const& counts) {
+                if (connection.expired())
+                    return;
+
+                protocol::reply_character_counts reply;
+                for (auto [realm, count] : counts)
+                    reply.counts.emplace_back(protocol::character_count{realm, count});
+
+                connection.lock()->send_answer(sender, reply.encode());
+            });
+
+        return shared::network::state_result::ok;
+    }
+
+    shared::network::state_result
+    connection::connected::on_subscribe_account_invalidations(std::weak_ptr<accountserver::connection>& connection_ptr,
+                                                               uint64 sender,
+                                                               protocol::subscribe_account_invalidations& packet)
+    {
+        auto conn = connection_ptr.lock();
+
+        // Won't be answered until an account has been invalidated
+        conn->account_invalidations_.subscribe(
+            packet.last_sequence, [sender, connection = connection_ptr](uint64 sequence, bool flush_all,
+                                                                        std::vector<std::string> const& names) {
+                if (connection.expired())
+                    return;
+
+                protocol::account_invalidations reply;
+                reply.sequence = sequence;
+                reply.flush_all = flush_all;
+                reply.account_names = names;
+
+                connection.lock()->send_answer(sender, reply.encode());
+            });
+
+        return shared::network::state_result::ok;
+    }
+
+    shared::network::state_result
+    connection::connected::on_ip_bans_request(std::weak_ptr<accountserver::connection>& connection_ptr, uint64 sender,
+                                              protocol::request_ip_bans& packet)
+    {
+        auto ip_ban_dao = shared::database::dal::get_ip_ban_dao(get_login_database());
+        ip_ban_dao->active_bans([sender, connection = connection_ptr](std::vector<shared::database::ip_ban> bans) {
+            if (connection.expired())
+                return;
+
+            protocol::reply_ip_bans reply;
+            for (auto const& ban : bans)
+                reply.bans.emplace_back(protocol::ip_ban_entry{ban.network, ban.allow != 0});
+
+            connection.lock()->send_answer(sender, reply.encode());
+        });
 
         return shared::network::state_result::ok;
     }
@@ -29,8 +29,16 @@
 #include <keycap/root/network/service_type.hpp>
 #include <keycap/root/network/srp6/server.hpp>
 
+#include <array>
+#include <memory>
+#include <utility>
 #include <variant>
 
+namespace spdlog
+{
+    class logger;
+}
+
 namespace keycap::protocol
 {
     class request_account_data;
@@ -45,17 +53,31 @@ namespace keycap::protocol
     class login_telemetry;
 
     class char_create;
+    class char_delete;
+    class request_character_counts;
+
+    class subscribe_account_invalidations;
+
+    class request_ip_bans;
 }
 
 namespace keycap::accountserver
 {
+    class account_batcher;
+    class account_invalidations;
     class character_id_provider;
+    class character_count_cache;
+    class character_list_cache;
+    class telemetry_sink;
 
     class connection : public keycap::root::network::service_connection
     {
       public:
         explicit connection(boost::asio::ip::tcp::socket socket, keycap::root::network::service_base& service,
-                            character_id_provider& character_id_provider);
+                            character_id_provider& character_id_provider,
+                            character_count_cache& character_count_cache, character_list_cache& character_list_cache,
+                            account_invalidations& account_invalidations, account_batcher& account_batcher,
+                            telemetry_sink& telemetry_sink);
 
         bool on_data(keycap::root::network::data_router const& router, keycap::root::network::service_type service,
                      uint64 sender, keycap::root::network::memory_stream& stream) override;
@@ -70,7 +92,7 @@ namespace keycap::accountserver
             shared::network::state_result on_data(connection& connection, uint64 sender,
                                                   keycap::root::network::memory_stream& stream);
 
-            std::string name = "Disconnected";
+            static constexpr char const* name = "Disconnected";
         };
 
         // Connection was just established
@@ -79,9 +101,27 @@ namespace keycap::accountserver
             shared::network::state_result on_data(connection& connection, uint64 sender,
                                                   keycap::root::network::memory_stream& stream);
 
-            std::string name = "JustConnected";
+            static constexpr char const* name = "JustConnected";
 
           private:
+            using handler = shared::network::state_result (*)(connected& state,
+                                                               std::weak_ptr<accountserver::connection>& connection_ptr,
+                                                               uint64 sender,
+                                                               keycap::root::network::memory_stream& stream);
+
+            // Decodes the packet the given handler expects and passes it on
+            template <auto HANDLER>
+            static shared::network::state_result dispatch(connected& state,
+                                                          std::weak_ptr<accountserver::connection>& connection_ptr,
+                                                          uint64 sender, keycap::root::network::memory_stream& stream);
+
+            // Returns the command byte of the packet the given handler expects and its dispatch function
+            template <auto HANDLER>
+            static constexpr std::pair<size_t, handler> entry();
+
+            // The handlers of all shared_commands indexed by the command byte. Commands without a handler are null
+            static std::array<handler, 256> const handlers;
+
             shared::network::state_result
             on_account_data_request(std::weak_ptr<accountserver::connection>& connection_ptr, uint64 sender,
                                     protocol::request_account_data& packet);
@@ -111,6 +151,20 @@ namespace keycap::accountserver
 
             shared::network::state_result on_char_create(std::weak_ptr<accountserver::connection>& connection_ptr,
                                                          uint64 sender, protocol::char_create& packet);
+
+            shared::network::state_result on_char_delete(std::weak_ptr<accountserver::connection>& connection_ptr,
+                                                         uint64 sender, protocol::char_delete& packet);
+
+            shared::network::state_result
+            on_character_counts_request(std::weak_ptr<accountserver::connection>& connection_ptr, uint64 sender,
+                                        protocol::request_character_counts& packet);
+
+            shared::network::state_result
+            on_subscribe_account_invalidations(std::weak_ptr<accountserver::connection>& connection_ptr,
+                                               uint64 sender, protocol::subscribe_account_invalidations& packet);
+
+            shared::network::state_result on_ip_bans_request(std::weak_ptr<accountserver::connection>& connection_ptr,
+                                                             uint64 sender, protocol::request_ip_bans& packet);
         };
 
         std::variant<disconnected, connected> state_;
@@ -118,5 +172,14 @@ namespace keycap::accountserver
         keycap::root::network::memory_stream input_stream_;
 
         character_id_provider& character_id_provider_;
+        character_count_cache& character_count_cache_;
+        character_list_cache& character_list_cache_;
+        account_invalidations& account_invalidations_;
+        account_batcher& account_batcher_;
+        telemetry_sink& telemetry_sink_;
+
+        // Handed to the handlers, so they don't need to call shared_from_this() for every message
+        std::weak_ptr<connection> self_;
+        std::shared_ptr<spdlog::logger> logger_;
     };
 }
\ No newline at end of file
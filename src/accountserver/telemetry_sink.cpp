@@ -0,0 +1,212 @@
+/*
+    Copyright 2018-2019 KeycapEmu
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "telemetry_sink.hpp"
+#include "account_batcher.hpp"
+
+#include <database/daos/user_telemetry.hpp>
+#include <string_utility.hpp>
+
+#include <zlib.h>
+
+#include <algorithm>
+#include <ctime>
+#include <iterator>
+#include <optional>
+
+extern keycap::shared::database::database& get_login_database();
+
+namespace keycap::accountserver
+{
+    // The id cache is simply started over once it grows beyond this
+    constexpr size_t max_cached_account_ids = 65536;
+
+    namespace
+    {
+        // Returns the given data compressed with zlib
+        std::optional<std::string> compress(std::string const& data, int level)
+        {
+            auto size = compressBound(static_cast<uLong>(data.size()));
+            std::string compressed(size, '\0');
+
+            auto result = compress2(reinterpret_cast<Bytef*>(&compressed[0]), &size,
+                                    reinterpret_cast<Bytef const*>(data.data()), static_cast<uLong>(data.size()),
+                                    level);
+            if (result != Z_OK)
+                return std::nullopt;
+
+            compressed.resize(size);
+            return compressed;
+        }
+    }
+
+    telemetry_sink::telemetry_sink(boost::asio::io_service& io_service, account_batcher& account_batcher,
+                                   telemetry_settings settings)
+      : io_service_{io_service}
+      , account_batcher_{account_batcher}
+      , settings_{settings}
+      , timer_{io_service}
+      , counters_{std::make_shared<counters>()}
+    {
+        buffer_.reserve(settings_.batch_size);
+        schedule_flush();
+    }
+
+    telemetry_sink::~telemetry_sink()
+    {
+        std::unique_lock<std::mutex> lock{mutex_};
+
+        boost::system::error_code ignored;
+        timer_.cancel(ignored);
+
+        // Their callbacks capture this and may still add records
+        lookup_done_.wait(lock, [this] { return pending_lookups_ == 0; });
+
+        flush_locked();
+    }
+
+    void telemetry_sink::remember(std::string const& account_name, uint32 account_id)
+    {
+        std::lock_guard<std::mutex> lock{mutex_};
+        remember_locked(shared::to_upper(account_name), account_id);
+    }
+
+    void telemetry_sink::submit(std::string const& account_name, std::string telemetry)
+    {
+        auto date_taken = static_cast<uint64>(time(nullptr));
+        auto key = shared::to_upper(account_name);
+
+        // Compressing here spreads the work over the callers instead of keeping the database threads busy with it
+        auto raw_size = static_cast<uint32>(telemetry.size());
+        auto compressed = compress(telemetry, settings_.compression_level);
+        if (!compressed)
+        {
+            ++counters_->failed;
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock{mutex_};
+
+            auto itr = account_ids_.find(key);
+            if (itr != account_ids_.end())
+                return enqueue_locked(shared::database::user_telemetry{itr->second, date_taken,
+                                                                       std::move(*compressed), raw_size});
+
+            ++pending_lookups_;
+        }
+
+        account_batcher_.lookup(key, [this, key, date_taken, telemetry = std::move(*compressed), raw_size](
+                                         std::optional<shared::database::user> user, bool failed) mutable {
+            std::lock_guard<std::mutex> lock{mutex_};
+
+            // Just like the foreign key would, drop telemetry of unknown users
+            if (user)
+            {
+                remember_locked(key, user->id);
+                enqueue_locked(shared::database::user_telemetry{user->id, date_taken, std::move(telemetry), raw_size});
+            }
+
+            // The sink may be destroyed as soon as the lock is released
+            --pending_lookups_;
+            lookup_done_.notify_all();
+        });
+    }
+
+    void telemetry_sink::flush()
+    {
+        std::lock_guard<std::mutex> lock{mutex_};
+        flush_locked();
+    }
+
+    void telemetry_sink::remember_locked(std::string key, uint32 account_id)
+    {
+        if (account_ids_.size() >= max_cached_account_ids)
+            account_ids_.clear();
+
+        account_ids_[std::move(key)] = account_id;
+    }
+
+    void telemetry_sink::enqueue_locked(shared::database::user_telemetry record)
+    {
+        if (buffer_.size() + counters_->in_flight >= settings_.capacity)
+        {
+            ++counters_->dropped;
+            return;
+        }
+
+        buffer_.emplace_back(std::move(record));
+
+        if (buffer_.size() >= settings_.batch_size)
+            flush_locked();
+    }
+
+    void telemetry_sink::flush_locked()
+    {
+        if (buffer_.empty())
+            return;
+
+        std::vector<shared::database::user_telemetry> records;
+        records.reserve(settings_.batch_size);
+        records.swap(buffer_);
+
+        counters_->in_flight += records.size();
+        io_service_.post(
+            [counters = counters_, records = std::move(records)]() mutable { write(counters, std::move(records)); });
+    }
+
+    void telemetry_sink::schedule_flush()
+    {
+        timer_.expires_from_now(boost::posix_time::milliseconds{settings_.flush_interval.count()});
+        timer_.async_wait([this](boost::system::error_code const& error) {
+            if (error)
+                return;
+
+            std::lock_guard<std::mutex> lock{mutex_};
+            flush_locked();
+            schedule_flush();
+        });
+    }
+
+    void telemetry_sink::write(std::shared_ptr<counters> counters,
+                               std::vector<shared::database::user_telemetry> records)
+    {
+        auto telemetry_dao = shared::database::dal::get_user_telemetry_dao(get_login_database());
+
+        // Every distinct row count is another prepared statement on each connection, so the records are written in
+        // chunks of powers of two
+        auto itr = records.begin();
+        while (itr != records.end())
+        {
+            size_t count = 1;
+            auto remaining = static_cast<size_t>(records.end() - itr);
+            while (count * 2 <= remaining)
+                count *= 2;
+
+            std::vector<shared::database::user_telemetry> chunk{std::make_move_iterator(itr),
+                                                                std::make_move_iterator(itr + count)};
+            itr += count;
+
+            telemetry_dao->add_telemetry(std::move(chunk), [counters, count](bool success) {
+                counters->in_flight -= count;
+                if (success)
+                    counters->written += count;
+                else
+                    counters->failed += count;
+            });
+        }
+    }
+}
@@ -0,0 +1,133 @@
+/*
+    Copyright 2018-2019 KeycapEmu
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#pragma once
+
+#include <generated/user_telemetry.hpp>
+
+#include <keycap/root/types.hpp>
+
+#include <boost/asio/deadline_timer.hpp>
+#include <boost/asio/io_service.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace keycap::accountserver
+{
+    class account_batcher;
+
+    struct telemetry_settings
+    {
+        // Records that may be buffered or in flight at once. Anything beyond that is dropped
+        size_t capacity = 4096;
+        // A flush is started right away once this many records are buffered. Should be a power of two
+        size_t batch_size = 256;
+        // Buffered records are flushed at least this often
+        std::chrono::milliseconds flush_interval{1000};
+        // zlib compression level from 1 (fastest) to 9 (smallest)
+        int compression_level = 6;
+    };
+
+    // Write-behind sink for the telemetry clients send on login.
+    // Records are buffered in memory and written with multi-row INSERTs once enough of them have been collected or the
+    // flush interval has passed. The telemetry is stored zlib compressed, raw_size holds its uncompressed size.
+    // Account ids come from a cache that is filled by the account lookups of the logon servers and only fall back to
+    // a (batched) lookup on a miss.
+    class telemetry_sink
+    {
+      public:
+        telemetry_sink(boost::asio::io_service& io_service, account_batcher& account_batcher,
+                       telemetry_settings settings);
+
+        // Waits for outstanding account lookups and hands the remaining records to the io_service, which has to keep
+        // running until they've been written
+        ~telemetry_sink();
+
+        // Remembers the id of the given account so its telemetry doesn't need to look it up
+        void remember(std::string const& account_name, uint32 account_id);
+
+        // Compresses the given telemetry of the given account on the calling thread and buffers it. It's dropped if
+        // the buffer is full
+        void submit(std::string const& account_name, std::string telemetry);
+
+        // Writes all buffered records
+        void flush();
+
+        // Returns the number of records that have been written
+        uint64_t written() const
+        {
+            return counters_->written;
+        }
+
+        // Returns the number of records that have been dropped because the buffer was full
+        uint64_t dropped() const
+        {
+            return counters_->dropped;
+        }
+
+        // Returns the number of records that couldn't be compressed or written
+        uint64_t failed() const
+        {
+            return counters_->failed;
+        }
+
+      private:
+        // Outlives the sink, the last writes may finish after it has been destroyed
+        struct counters
+        {
+            std::atomic_uint64_t written{0};
+            std::atomic_uint64_t dropped{0};
+            std::atomic_uint64_t failed{0};
+            std::atomic_size_t in_flight{0};
+        };
+
+        // Caches the id of the account with the given upper case name. Requires mutex_ to be locked
+        void remember_locked(std::string key, uint32 account_id);
+
+        // Buffers the given record whose telemetry has already been compressed. Requires mutex_ to be locked
+        void enqueue_locked(shared::database::user_telemetry record);
+
+        // Hands the buffered records to a database thread. Requires mutex_ to be locked
+        void flush_locked();
+
+        void schedule_flush();
+
+        static void write(std::shared_ptr<counters> counters, std::vector<shared::database::user_telemetry> records);
+
+        boost::asio::io_service& io_service_;
+        account_batcher& account_batcher_;
+        telemetry_settings settings_;
+
+        std::mutex mutex_;
+        // Signalled whenever an account lookup of submit has finished
+        std::condition_variable lookup_done_;
+        // Account lookups that still have to call back into the sink. It waits for them before being destroyed
+        size_t pending_lookups_ = 0;
+        boost::asio::deadline_timer timer_;
+        std::vector<shared::database::user_telemetry> buffer_;
+        // Keyed by the upper case account name
+        std::unordered_map<std::string, uint32> account_ids_;
+
+        std::shared_ptr<counters> counters_;
+    };
+}
@@ -0,0 +1,149 @@
+/*
+    Copyright 2018-2019 KeycapEmu
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "account_cache.hpp"
+
+#include <network/services.hpp>
+#include <string_utility.hpp>
+
+#include <spdlog/spdlog.h>
+
+namespace net = keycap::root::network;
+namespace shared_net = keycap::shared::network;
+
+namespace keycap::logonserver
+{
+    account_cache::account_cache(account_cache_limits const& limits)
+      : limits_{limits}
+    {
+    }
+
+    bool account_cache::find(std::string const& account_name, std::optional<protocol::account_data>& data)
+    {
+        auto name = shared::to_upper(account_name);
+
+        std::lock_guard<std::mutex> lock{mutex_};
+
+        auto itr = index_.find(name);
+        if (itr == index_.end())
+        {
+            ++misses_;
+            return false;
+        }
+
+        if (itr->second->expires <= clock::now())
+        {
+            erase(itr->second);
+            ++misses_;
+            return false;
+        }
+
+        entries_.splice(entries_.begin(), entries_, itr->second);
+        data = itr->second->data;
+
+        if (data)
+            ++hits_;
+        else
+            ++negative_hits_;
+
+        return true;
+    }
+
+    void account_cache::insert(std::string const& account_name, std::optional<protocol::account_data> const& data)
+    {
+        if (limits_.capacity == 0)
+            return;
+
+        auto name = shared::to_upper(account_name);
+        auto expires = clock::now() + (data ? limits_.ttl : limits_.negative_ttl);
+
+        std::lock_guard<std::mutex> lock{mutex_};
+
+        if (auto itr = index_.find(name); itr != index_.end())
+            erase(itr->second);
+
+        while (entries_.size() >= limits_.capacity)
+        {
+            erase(std::prev(entries_.end()));
+            ++evictions_;
+        }
+
+        entries_.push_front(entry{name, data, expires});
+        index_.emplace(std::move(name), entries_.begin());
+    }
+
+    void account_cache::invalidate(std::string const& account_name)
+    {
+        auto name = shared::to_upper(account_name);
+
+        std::lock_guard<std::mutex> lock{mutex_};
+
+        if (auto itr = index_.find(name); itr != index_.end())
+            erase(itr->second);
+    }
+
+    void account_cache::clear()
+    {
+        std::lock_guard<std::mutex> lock{mutex_};
+
+        entries_.clear();
+        index_.clear();
+    }
+
+    void account_cache::watch_invalidations(net::service_locator& locator, boost::asio::io_service& io_service,
+                                            uint64 last_sequence)
+    {
+        protocol::subscribe_account_invalidations request;
+        request.last_sequence = last_sequence;
+
+        // The account service holds on to the request until an account has changed
+        locator.send_registered(
+            shared_net::account_service_type, request.encode(), io_service,
+            [this, &locator, &io_service](net::service_type sender, net::memory_stream data) {
+                if (data.peek<protocol::shared_command>() != protocol::shared_command::account_invalidations)
+                    return false;
+
+                auto reply = protocol::account_invalidations::decode(data);
+
+                if (reply.flush_all)
+                {
+                    auto logger = keycap::root::utility::get_safe_logger("connections");
+                    logger->info("[account_cache] Missed account invalidations, dropping all cached accounts");
+                    clear();
+                }
+                else
+                {
+                    for (auto const& account_name : reply.account_names)
+                        invalidate(account_name);
+                }
+
+                watch_invalidations(locator, io_service, reply.sequence);
+                return true;
+            });
+    }
+
+    size_t account_cache::size() const
+    {
+        std::lock_guard<std::mutex> lock{mutex_};
+        return entries_.size();
+    }
+
+    void account_cache::erase(std::list<entry>::iterator itr)
+    {
+        index_.erase(itr->account_name);
+        entries_.erase(itr);
+    }
+}
@@ -0,0 +1,117 @@
+/*
+    Copyright 2018-2019 KeycapEmu
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#pragma once
+
+#include <generated/shared_protocol.hpp>
+
+#include <keycap/root/network/service_locator.hpp>
+
+#include <boost/asio/io_service.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+namespace keycap::logonserver
+{
+    struct account_cache_limits
+    {
+        // Maximum number of accounts (known or unknown) kept in memory
+        size_t capacity = 100000;
+        // How long an account's data may be served from the cache
+        std::chrono::seconds ttl{300};
+        // How long we remember that an account doesn't exist
+        std::chrono::seconds negative_ttl{10};
+    };
+
+    // Caches the account data of recent logins so repeated attempts (typos, client retries, etc.) don't cost an account
+    // service round trip. Accounts that don't exist are cached too but only briefly.
+    // Entries are evicted least recently used first and dropped when the account service tells us they've changed.
+    class account_cache
+    {
+        using clock = std::chrono::steady_clock;
+
+      public:
+        explicit account_cache(account_cache_limits const& limits);
+
+        // Returns true if the given account is cached. data is left empty if the account is known not to exist
+        bool find(std::string const& account_name, std::optional<protocol::account_data>& data);
+
+        // Caches the given account data or that the account doesn't exist if data is empty
+        void insert(std::string const& account_name, std::optional<protocol::account_data> const& data);
+
+        // Drops the given account from the cache
+        void invalidate(std::string const& account_name);
+
+        // Drops all accounts from the cache
+        void clear();
+
+        // Subscribes to the invalidations of the account service the given locator points to. Must be called for
+        // every account service whenever it has been (re-)located
+        void watch_invalidations(keycap::root::network::service_locator& locator, boost::asio::io_service& io_service,
+                                 uint64 last_sequence = 0);
+
+        size_t size() const;
+
+        uint64 hits() const
+        {
+            return hits_;
+        }
+
+        uint64 negative_hits() const
+        {
+            return negative_hits_;
+        }
+
+        uint64 misses() const
+        {
+            return misses_;
+        }
+
+        uint64 evictions() const
+        {
+            return evictions_;
+        }
+
+      private:
+        struct entry
+        {
+            std::string account_name;
+            std::optional<protocol::account_data> data;
+            clock::time_point expires;
+        };
+
+        // Removes the given entry. Requires mutex_ to be held
+        void erase(std::list<entry>::iterator itr);
+
+        account_cache_limits limits_;
+
+        mutable std::mutex mutex_;
+        // Most recently used first
+        std::list<entry> entries_;
+        std::unordered_map<std::string, std::list<entry>::iterator> index_;
+
+        std::atomic_uint64_t hits_{0};
+        std::atomic_uint64_t negative_hits_{0};
+        std::atomic_uint64_t misses_{0};
+        std::atomic_uint64_t evictions_{0};
+    };
+}
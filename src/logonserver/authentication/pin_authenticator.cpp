@@ -16,7 +16,8 @@
 
 #include "pin_authenticator.hpp"
 
-#include <botan/auto_rng.h>
+#include <cryptography/random.hpp>
+
 #include <botan/bigint.h>
 #include <botan/sha160.h>
 
@@ -31,7 +32,7 @@ namespace keycap::logonserver
 
         std::shuffle(pin_grid_.begin(), pin_grid_.end(), generator);
 
-        auto server_salt = Botan::AutoSeeded_RNG().random_vec(salt_length_);
+        auto server_salt = shared::cryptography::random_bytes(salt_length_);
         std::reverse_copy(server_salt.begin(), server_salt.end(), server_salt_.begin());
         // std::copy(server_salt.begin(), server_salt.end(), server_salt_.begin());
     }
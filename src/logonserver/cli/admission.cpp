@@ -0,0 +1,61 @@
+/*
+    Copyright 2018-2019 KeycapEmu
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "../network/admission_control.hpp"
+#include "../network/connection_reaper.hpp"
+
+#include <cli/command.hpp>
+#include <generated/permissions.hpp>
+#include <rbac/role.hpp>
+
+#include <spdlog/fmt/fmt.h>
+
+#include <iostream>
+
+namespace rbac = keycap::shared::rbac;
+
+extern keycap::logonserver::admission_control& get_admission_control();
+extern keycap::logonserver::connection_reaper& get_connection_reaper();
+
+namespace keycap::logonserver::cli
+{
+    bool admission_command(std::vector<std::string> const& args, rbac::role const& role)
+    {
+        auto& admission = get_admission_control();
+        auto const& limits = admission.limits();
+
+        std::cout << fmt::format("Half-open logins: {}/{} tracked sources: {}\n", admission.half_open(),
+                                 limits.max_half_open, admission.tracked_sources());
+        std::cout << fmt::format("Admitted: {} rejected per ip: {} globally: {} half-open: {}\n", admission.admitted(),
+                                 admission.rejected_per_ip(), admission.rejected_global(),
+                                 admission.rejected_half_open());
+
+        auto& reaper = get_connection_reaper();
+        std::cout << fmt::format("Closed stalled connections: {} pending deadlines: {}\n", reaper.reaped(),
+                                 reaper.pending());
+
+        return true;
+    }
+
+    keycap::shared::cli::command register_admission()
+    {
+        using keycap::shared::permission;
+        using namespace std::string_literals;
+
+        return keycap::shared::cli::command{"admission"s, permission::CommandAdmission, &admission_command,
+                                            "Displays the connection admission and timeout counters"s};
+    }
+}
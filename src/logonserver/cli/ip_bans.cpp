@@ -0,0 +1,58 @@
+/*
+    Copyright 2018-2019 KeycapEmu
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+#include <cli/command.hpp>
+#include <generated/permissions.hpp>
+#include <network/ip_ban_list.hpp>
+#include <rbac/role.hpp>
+
+#include <iostream>
+
+namespace rbac = keycap::shared::rbac;
+
+extern keycap::shared::network::ip_ban_list& get_ip_bans();
+extern bool reload_ip_bans();
+
+namespace keycap::logonserver::cli
+{
+    bool ip_bans_command(std::vector<std::string> const& args, rbac::role const& role)
+    {
+        if (!args.empty() && args[0] == "reload")
+        {
+            if (!reload_ip_bans())
+            {
+                std::cout << "There is no accountserver to load the ip bans from\n";
+                return false;
+            }
+
+            std::cout << "Reloading the ip bans\n";
+            return true;
+        }
+
+        auto& ip_bans = get_ip_bans();
+        std::cout << "Networks: " << ip_bans.size() << "\n";
+        std::cout << "Rejected connections: " << ip_bans.rejected() << "\n";
+        return true;
+    }
+
+    keycap::shared::cli::command register_ip_bans()
+    {
+        using keycap::shared::permission;
+        using namespace std::string_literals;
+
+        return keycap::shared::cli::command{"ipbans"s, permission::CommandIpBans, &ip_bans_command,
+                                            "Displays or reloads the banned networks. Arguments: [reload]"s};
+    }
+}
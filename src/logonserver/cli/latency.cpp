@@ -0,0 +1,54 @@
+/*
+    Copyright 2018-2019 KeycapEmu
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "../login_metrics.hpp"
+
+#include <cli/command.hpp>
+#include <generated/permissions.hpp>
+#include <rbac/role.hpp>
+
+#include <iostream>
+
+namespace rbac = keycap::shared::rbac;
+
+extern keycap::logonserver::login_metrics& get_login_metrics();
+
+namespace keycap::logonserver::cli
+{
+    bool latency_command(std::vector<std::string> const& args, rbac::role const& role)
+    {
+        auto& metrics = get_login_metrics();
+
+        if (!args.empty() && args[0] == "reset")
+        {
+            metrics.reset();
+            std::cout << "Login latencies have been reset\n";
+            return true;
+        }
+
+        std::cout << metrics.report();
+        return true;
+    }
+
+    keycap::shared::cli::command register_latency()
+    {
+        using keycap::shared::permission;
+        using namespace std::string_literals;
+
+        return keycap::shared::cli::command{"latency"s, permission::CommandLatency, &latency_command,
+                                            "Displays the login pipeline's latencies. Arguments: [reset]"s};
+    }
+}
@@ -23,6 +23,11 @@ namespace keycap::logonserver::cli
     namespace cli = keycap::shared::cli;
     extern cli::command register_help();
     extern cli::command register_account();
+    extern cli::command register_crypto();
+    extern cli::command register_admission();
+    extern cli::command register_latency();
+    extern cli::command register_account_services();
+    extern cli::command register_ip_bans();
 
     namespace impl
     {
@@ -35,5 +40,10 @@ namespace keycap::logonserver::cli
     void register_commands(cli::command_map& command_map)
     {
         impl::register_command(register_help(), command_map);
+        impl::register_command(register_crypto(), command_map);
+        impl::register_command(register_admission(), command_map);
+        impl::register_command(register_latency(), command_map);
+        impl::register_command(register_account_services(), command_map);
+        impl::register_command(register_ip_bans(), command_map);
     }
 }
\ No newline at end of file
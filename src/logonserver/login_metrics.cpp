@@ -0,0 +1,54 @@
+/*
+    Copyright 2018-2019 KeycapEmu
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "login_metrics.hpp"
+
+#include <spdlog/fmt/fmt.h>
+
+namespace keycap::logonserver
+{
+    std::string login_metrics::report() const
+    {
+        std::string report;
+
+        auto append = [&report](char const* name, shared::metrics::per_thread_histogram const& histogram) {
+            report += fmt::format("{:<20} {}\n", name, histogram.summary());
+        };
+
+        append("just_connected", just_connected);
+        append("challanged", challanged);
+        append("transferring", transferring);
+        append("reconnect_challanged", reconnect_challanged);
+        append("account_lookup", account_lookup);
+        append("client_proof", client_proof);
+        append("proof_verification", proof_verification);
+        append("login", login);
+
+        return report;
+    }
+
+    void login_metrics::reset()
+    {
+        just_connected.reset();
+        challanged.reset();
+        transferring.reset();
+        reconnect_challanged.reset();
+        account_lookup.reset();
+        client_proof.reset();
+        proof_verification.reset();
+        login.reset();
+    }
+}
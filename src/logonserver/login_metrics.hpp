@@ -0,0 +1,50 @@
+/*
+    Copyright 2018-2019 KeycapEmu
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#pragma once
+
+#include <metrics/per_thread_histogram.hpp>
+
+#include <string>
+
+namespace keycap::logonserver
+{
+    // Latencies of the login pipeline. Used to tell whether slow logins are caused by the account service, the crypto
+    // or the clients themselves
+    struct login_metrics
+    {
+        // Time spent in each state of the client_connection
+        shared::metrics::per_thread_histogram just_connected;
+        shared::metrics::per_thread_histogram challanged;
+        shared::metrics::per_thread_histogram transferring;
+        shared::metrics::per_thread_histogram reconnect_challanged;
+
+        // Round trip of request_account_data to the account service. Cached accounts aren't recorded
+        shared::metrics::per_thread_histogram account_lookup;
+        // From sending the challange until the client's proof has arrived
+        shared::metrics::per_thread_histogram client_proof;
+        // From posting the proof to the crypto_executor until its result is back on the connection's strand
+        shared::metrics::per_thread_histogram proof_verification;
+        // From connecting until being authenticated
+        shared::metrics::per_thread_histogram login;
+
+        // Returns one line per histogram
+        std::string report() const;
+
+        // Removes all recorded values
+        void reset();
+    };
+}
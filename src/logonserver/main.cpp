@@ -14,21 +14,31 @@
     limitations under the License.
 */
 
+#include "account_cache.hpp"
 #include "cli/registrar.hpp"
+#include "login_metrics.hpp"
+#include "network/admission_control.hpp"
 #include "network/client_connection.hpp"
+#include "network/connection_reaper.hpp"
 #include "network/realm_service.hpp"
 #include "realm_manager.hpp"
 #include "version.hpp"
 
 #include <cli/helpers.hpp>
 #include <crash_dump.hpp>
+#include <cryptography/crypto_executor.hpp>
+#include <cryptography/ephemeral_pool.hpp>
 #include <logging/utility.hpp>
+#include <network/account_service_ring.hpp>
+#include <network/ip_ban_list.hpp>
+#include <network/reuseport_acceptor.hpp>
 #include <network/services.hpp>
 #include <rbac/rbac.hpp>
 
 #include <keycap/root/configuration/config_file.hpp>
 #include <keycap/root/network/data_router.hpp>
 #include <keycap/root/network/service_locator.hpp>
+#include <keycap/root/network/srp6/utility.hpp>
 #include <keycap/root/utility/meta.hpp>
 #include <keycap/root/utility/scope_exit.hpp>
 #include <keycap/root/utility/string.hpp>
@@ -40,8 +50,10 @@
 #include <spdlog/spdlog.h>
 
 #include <boost/algorithm/string/join.hpp>
+#include <boost/asio/deadline_timer.hpp>
 
 #include <iostream>
+#include <thread>
 
 namespace logging = keycap::shared::logging;
 
@@ -54,12 +66,14 @@ struct config
         std::string bind_ip;
         int16_t port;
         int threads;
+        // Gives every thread its own SO_REUSEPORT listener
+        bool reuse_port;
     } network;
 
     struct
     {
-        std::string host;
-        int16_t port;
+        // "host:port" of every accountserver
+        std::vector<std::string> hosts;
     } account_service;
 
     struct
@@ -67,6 +81,24 @@ struct config
         std::string host;
         int16_t port;
     } realm_service;
+
+    struct
+    {
+        int threads;
+        int queue_size;
+        int ephemeral_pool_size;
+    } cryptography;
+
+    keycap::logonserver::admission_limits admission;
+
+    keycap::logonserver::account_cache_limits account_cache;
+
+    keycap::logonserver::connection_timeouts timeouts;
+
+    struct
+    {
+        int report_interval;
+    } metrics;
 };
 
 keycap::shared::cli::command_map commands;
@@ -96,12 +128,113 @@ auto& get_command_map()
     return commands;
 }
 
+std::unique_ptr<keycap::shared::cryptography::srp6::ephemeral_pool> ephemeral_pool;
+
+keycap::shared::cryptography::srp6::ephemeral_pool& get_ephemeral_pool()
+{
+    return *ephemeral_pool;
+}
+
+std::unique_ptr<keycap::shared::cryptography::crypto_executor> crypto_executor;
+
+keycap::shared::cryptography::crypto_executor& get_crypto_executor()
+{
+    return *crypto_executor;
+}
+
+std::unique_ptr<keycap::logonserver::admission_control> admission_control;
+
+keycap::logonserver::admission_control& get_admission_control()
+{
+    return *admission_control;
+}
+
+std::unique_ptr<keycap::logonserver::connection_reaper> connection_reaper;
+
+keycap::logonserver::connection_reaper& get_connection_reaper()
+{
+    return *connection_reaper;
+}
+
+std::unique_ptr<keycap::logonserver::account_cache> account_cache;
+
+keycap::logonserver::account_cache& get_account_cache()
+{
+    return *account_cache;
+}
+
+keycap::logonserver::login_metrics& get_login_metrics()
+{
+    static keycap::logonserver::login_metrics login_metrics;
+    return login_metrics;
+}
+
+boost::asio::io_service& get_net_service()
+{
+    static boost::asio::io_service net_service;
+    return net_service;
+}
+
+std::unique_ptr<keycap::shared::network::account_service_ring> account_services;
+
+keycap::shared::network::account_service_ring& get_account_services()
+{
+    return *account_services;
+}
+
+keycap::shared::network::ip_ban_list ip_bans;
+
+keycap::shared::network::ip_ban_list& get_ip_bans()
+{
+    return ip_bans;
+}
+
+// Reloads the ip bans from any known accountserver. Returns false if there is none
+bool reload_ip_bans()
+{
+    auto locator = get_account_services().any();
+    if (!locator)
+        return false;
+
+    keycap::shared::network::fetch_ip_bans(*locator, get_net_service(), ip_bans);
+    return true;
+}
+
+// Adds the accountserver at the given endpoint, keeps the account cache subscribed to its invalidations and loads the
+// ip bans from it
+bool join_account_service(std::string const& endpoint)
+{
+    namespace net = keycap::root::network;
+
+    net::service_locator::located_callback_container container{get_net_service(), [](auto& locator, auto type) {
+        get_account_cache().watch_invalidations(locator, get_net_service());
+        keycap::shared::network::fetch_ip_bans(locator, get_net_service(), ip_bans);
+    }};
+
+    return account_services->join(endpoint, container);
+}
+
 boost::asio::io_service& get_db_service()
 {
     static boost::asio::io_service db_service;
     return db_service;
 }
 
+// Logs the login latencies every `interval` seconds
+void schedule_metrics_report(boost::asio::deadline_timer& timer, int interval)
+{
+    timer.expires_from_now(boost::posix_time::seconds{interval});
+    timer.async_wait([&timer, interval](boost::system::error_code const& error) {
+        if (error)
+            return;
+
+        auto console = keycap::root::utility::get_safe_logger("console");
+        console->info("Login latencies:\n{}", get_login_metrics().report());
+
+        schedule_metrics_report(timer, interval);
+    });
+}
+
 config parse_config(std::string config_file)
 {
     keycap::root::configuration::config_file cfg_file{config_file};
@@ -112,13 +245,42 @@ config parse_config(std::string config_file)
     conf.network.bind_ip = cfg_file.get_or_default<std::string>("Network", "BindIp", "127.0.0.1");
     conf.network.port = cfg_file.get_or_default<int16_t>("Network", "Port", 3724);
     conf.network.threads = cfg_file.get_or_default<int>("Network", "Threads", 1);
+    conf.network.reuse_port = cfg_file.get_or_default<bool>("Network", "ReusePort", false);
 
-    conf.account_service.host = cfg_file.get_or_default<std::string>("AccountService", "Host", "127.0.0.1");
-    conf.account_service.port = cfg_file.get_or_default<int16_t>("AccountService", "Port", 6660);
+    // Hosts takes precedence over the single Host and Port
+    auto account_host = cfg_file.get_or_default<std::string>("AccountService", "Host", "127.0.0.1");
+    auto account_port = cfg_file.get_or_default<int16_t>("AccountService", "Port", 6660);
+    auto account_hosts = cfg_file.get_or_default<std::string>("AccountService", "Hosts",
+                                                              fmt::format("{}:{}", account_host, account_port));
+    conf.account_service.hosts = keycap::shared::network::parse_endpoints(account_hosts);
 
     conf.realm_service.host = cfg_file.get_or_default<std::string>("RealmService", "Host", "127.0.0.1");
     conf.realm_service.port = cfg_file.get_or_default<int16_t>("RealmService", "Port", 6662);
 
+    conf.cryptography.threads = cfg_file.get_or_default<int>("Cryptography", "Threads", 2);
+    conf.cryptography.queue_size = cfg_file.get_or_default<int>("Cryptography", "QueueSize", 1024);
+    conf.cryptography.ephemeral_pool_size = cfg_file.get_or_default<int>("Cryptography", "EphemeralPoolSize", 1024);
+
+    conf.admission.per_ip_rate = cfg_file.get_or_default<double>("Admission", "PerIpRate", 2.0);
+    conf.admission.per_ip_burst = cfg_file.get_or_default<double>("Admission", "PerIpBurst", 10.0);
+    conf.admission.global_rate = cfg_file.get_or_default<double>("Admission", "GlobalRate", 200.0);
+    conf.admission.global_burst = cfg_file.get_or_default<double>("Admission", "GlobalBurst", 400.0);
+    conf.admission.max_half_open = cfg_file.get_or_default<int>("Admission", "MaxHalfOpen", 512);
+
+    conf.account_cache.capacity = cfg_file.get_or_default<size_t>("AccountCache", "Capacity", 100000);
+    conf.account_cache.ttl = std::chrono::seconds{cfg_file.get_or_default<int>("AccountCache", "Ttl", 300)};
+    conf.account_cache.negative_ttl =
+        std::chrono::seconds{cfg_file.get_or_default<int>("AccountCache", "NegativeTtl", 10)};
+
+    // A timeout of 0 disables the deadline of that state
+    conf.timeouts.just_connected = std::chrono::seconds{cfg_file.get_or_default<int>("Timeouts", "JustConnected", 10)};
+    conf.timeouts.challanged = std::chrono::seconds{cfg_file.get_or_default<int>("Timeouts", "Challanged", 10)};
+    conf.timeouts.transferring = std::chrono::seconds{cfg_file.get_or_default<int>("Timeouts", "Transferring", 120)};
+    conf.timeouts.authenticated = std::chrono::seconds{cfg_file.get_or_default<int>("Timeouts", "Authenticated", 300)};
+    conf.timeouts.resolution = std::chrono::milliseconds{cfg_file.get_or_default<int>("Timeouts", "Resolution", 100)};
+
+    conf.metrics.report_interval = cfg_file.get_or_default<int>("Metrics", "ReportInterval", 60);
+
     return conf;
 }
 
@@ -147,15 +309,63 @@ int main()
     keycap::logonserver::cli::register_commands(commands);
     register_default_commands(running);
 
+    auto parameter = net::srp6::get_parameters(net::srp6::group_parameters::_256);
+    ephemeral_pool = std::make_unique<keycap::shared::cryptography::srp6::ephemeral_pool>(
+        Botan::BigInt{parameter.N}, Botan::BigInt{parameter.g}, config.cryptography.ephemeral_pool_size);
+    QUICK_SCOPE_EXIT(ep, [] { ephemeral_pool.reset(); });
+
+    crypto_executor = std::make_unique<keycap::shared::cryptography::crypto_executor>(config.cryptography.threads,
+                                                                                      config.cryptography.queue_size);
+
     keycap::logonserver::realm_manager realm_manager;
     keycap::logonserver::realm_service realm_service{1, realm_manager};
     realm_service.start(config.realm_service.host, config.realm_service.port);
 
-    net::service_locator service_locator;
-    service_locator.locate(shared_net::account_service_type, config.account_service.host, config.account_service.port);
+    account_cache = std::make_unique<keycap::logonserver::account_cache>(config.account_cache);
+
+    // Ticks on the net_service and thus has to be destroyed after the net thread has been joined
+    connection_reaper = std::make_unique<keycap::logonserver::connection_reaper>(get_net_service(), config.timeouts);
+    connection_reaper->start();
+    QUICK_SCOPE_EXIT(cr, [] { connection_reaper.reset(); });
+
+    // Runs the account cache's invalidation subscription, the metrics report and the connection reaper
+    boost::asio::io_service::work net_work{get_net_service()};
+    std::thread net_thread{[] { get_net_service().run(); }};
+    SCOPE_EXIT(nt, [&] {
+        get_net_service().stop();
+        net_thread.join();
+    });
+
+    boost::asio::deadline_timer metrics_timer{get_net_service()};
+    if (config.metrics.report_interval > 0)
+        schedule_metrics_report(metrics_timer, config.metrics.report_interval);
+
+    account_services = std::make_unique<keycap::shared::network::account_service_ring>();
+    for (auto const& endpoint : config.account_service.hosts)
+    {
+        if (!join_account_service(endpoint))
+            console->error("Invalid account service endpoint {}", endpoint);
+    }
+
+    admission_control = std::make_unique<keycap::logonserver::admission_control>(config.admission);
+
+    keycap::logonserver::logon_service service{config.network.threads, *account_services, realm_manager,
+                                               *admission_control, *connection_reaper, ip_bans};
+
+    // Stops the acceptors' threads before the service and the connections are gone
+    keycap::shared::network::reuseport_server<keycap::logonserver::logon_service> reuseport{service};
+    if (config.network.reuse_port && keycap::shared::network::reuseport_supported())
+        reuseport.start(config.network.bind_ip, config.network.port, config.network.threads);
+    else
+    {
+        if (config.network.reuse_port)
+            console->warn("SO_REUSEPORT isn't supported on this platform. Falling back to a single acceptor");
+
+        service.start(config.network.bind_ip, config.network.port);
+    }
 
-    keycap::logonserver::logon_service service{config.network.threads, service_locator, realm_manager};
-    service.start(config.network.bind_ip, config.network.port);
+    // Stop the crypto threads before the connections they post their results to are gone
+    QUICK_SCOPE_EXIT(ce, [] { crypto_executor.reset(); });
 
     keycap::shared::cli::run_command_line(console_role, running);
 
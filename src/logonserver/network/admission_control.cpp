@@ -0,0 +1,108 @@
+/*
+    Copyright 2018-2019 KeycapEmu
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "admission_control.hpp"
+
+#include <algorithm>
+
+namespace keycap::logonserver
+{
+    // Don't bother pruning until this many sources are tracked
+    constexpr size_t prune_threshold = 1024;
+
+    admission_control::admission_control(admission_limits const& limits)
+      : limits_{limits}
+    {
+        auto now = clock::now();
+        global_.tokens = limits_.global_burst;
+        global_.updated = now;
+        last_prune_ = now;
+    }
+
+    std::unique_ptr<admission_control::ticket> admission_control::admit(std::string const& address)
+    {
+        // Reserve the half-open slot first so concurrent admissions can't exceed the cap
+        if (++half_open_ > limits_.max_half_open)
+        {
+            --half_open_;
+            ++rejected_half_open_;
+            return nullptr;
+        }
+
+        auto result = std::make_unique<ticket>(*this);
+        auto now = clock::now();
+
+        std::lock_guard<std::mutex> lock{mutex_};
+
+        auto [source, inserted] = sources_.try_emplace(address);
+        if (inserted)
+        {
+            source->second.tokens = limits_.per_ip_burst;
+            source->second.updated = now;
+        }
+
+        if (!source->second.take(limits_.per_ip_rate, limits_.per_ip_burst, now))
+        {
+            ++rejected_per_ip_;
+            return nullptr;
+        }
+
+        if (!global_.take(limits_.global_rate, limits_.global_burst, now))
+        {
+            ++rejected_global_;
+            return nullptr;
+        }
+
+        if (sources_.size() > prune_threshold && now - last_prune_ > std::chrono::seconds{1})
+            prune(now);
+
+        ++admitted_;
+        return result;
+    }
+
+    size_t admission_control::tracked_sources() const
+    {
+        std::lock_guard<std::mutex> lock{mutex_};
+        return sources_.size();
+    }
+
+    bool admission_control::token_bucket::take(double rate, double burst, clock::time_point now)
+    {
+        std::chrono::duration<double> elapsed = now - updated;
+        tokens = std::min(burst, tokens + elapsed.count() * rate);
+        updated = now;
+
+        if (tokens < 1.0)
+            return false;
+
+        tokens -= 1.0;
+        return true;
+    }
+
+    void admission_control::prune(clock::time_point now)
+    {
+        last_prune_ = now;
+
+        for (auto itr = sources_.begin(); itr != sources_.end();)
+        {
+            std::chrono::duration<double> elapsed = now - itr->second.updated;
+            if (itr->second.tokens + elapsed.count() * limits_.per_ip_rate >= limits_.per_ip_burst)
+                itr = sources_.erase(itr);
+            else
+                ++itr;
+        }
+    }
+}
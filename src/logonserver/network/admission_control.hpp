@@ -0,0 +1,138 @@
+/*
+    Copyright 2018-2019 KeycapEmu
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#pragma once
+
+#include <keycap/root/types.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace keycap::logonserver
+{
+    struct admission_limits
+    {
+        // Connections per second a single source address may open and how many it may open at once
+        double per_ip_rate = 2.0;
+        double per_ip_burst = 10.0;
+
+        // Connections per second all sources together may open and how many they may open at once
+        double global_rate = 200.0;
+        double global_burst = 400.0;
+
+        // Maximum number of connections that may be in the middle of logging in at the same time
+        int max_half_open = 512;
+    };
+
+    // Decides whether a new connection may start the (expensive) login sequence.
+    // Connections are rate limited per source address and globally using token buckets and the number of concurrent
+    // half-open logins is capped
+    class admission_control
+    {
+        using clock = std::chrono::steady_clock;
+
+      public:
+        // Holds one of the half-open slots until it's destroyed
+        class ticket
+        {
+          public:
+            explicit ticket(admission_control& owner)
+              : owner_{owner}
+            {
+            }
+
+            ~ticket()
+            {
+                --owner_.half_open_;
+            }
+
+            ticket(ticket const&) = delete;
+            ticket& operator=(ticket const&) = delete;
+
+          private:
+            admission_control& owner_;
+        };
+
+        explicit admission_control(admission_limits const& limits);
+
+        // Returns a ticket if a connection from the given address may be admitted or nullptr if it has to be rejected
+        std::unique_ptr<ticket> admit(std::string const& address);
+
+        admission_limits const& limits() const
+        {
+            return limits_;
+        }
+
+        uint64 admitted() const
+        {
+            return admitted_;
+        }
+
+        uint64 rejected_per_ip() const
+        {
+            return rejected_per_ip_;
+        }
+
+        uint64 rejected_global() const
+        {
+            return rejected_global_;
+        }
+
+        uint64 rejected_half_open() const
+        {
+            return rejected_half_open_;
+        }
+
+        int half_open() const
+        {
+            return half_open_;
+        }
+
+        // Returns the number of source addresses currently being tracked
+        size_t tracked_sources() const;
+
+      private:
+        struct token_bucket
+        {
+            double tokens = 0.0;
+            clock::time_point updated;
+
+            // Refills the bucket and takes a token if one is available
+            bool take(double rate, double burst, clock::time_point now);
+        };
+
+        // Forgets about sources whose buckets have been refilled completely
+        void prune(clock::time_point now);
+
+        admission_limits limits_;
+
+        mutable std::mutex mutex_;
+        token_bucket global_;
+        std::unordered_map<std::string, token_bucket> sources_;
+        clock::time_point last_prune_;
+
+        std::atomic_int half_open_{0};
+
+        std::atomic_uint64_t admitted_{0};
+        std::atomic_uint64_t rejected_per_ip_{0};
+        std::atomic_uint64_t rejected_global_{0};
+        std::atomic_uint64_t rejected_half_open_{0};
+    };
+}
@@ -15,11 +15,19 @@
 */
 
 #include "client_connection.hpp"
+#include "../login_metrics.hpp"
+
+#include <generated/shared_protocol.hpp>
+#include <network/services.hpp>
 
 #include <keycap/root/utility/scope_exit.hpp>
 
+#include <boost/asio/deadline_timer.hpp>
+
 #include <spdlog/spdlog.h>
 
+#include <algorithm>
+
 std::ostream& operator<<(std::ostream& os, std::vector<uint8_t> const& vec)
 {
     os << std::hex;
@@ -34,18 +42,43 @@ std::ostream& operator<<(std::ostream& os, std::vector<uint8_t> const& vec)
 
 namespace net = keycap::root::network;
 
+extern keycap::logonserver::login_metrics& get_login_metrics();
+
 namespace keycap::logonserver
 {
+    namespace
+    {
+        // How long the realm list waits for the user's character counts before it's sent without them
+        boost::posix_time::seconds const character_counts_timeout{2};
+    }
+
     client_connection::client_connection(boost::asio::ip::tcp::socket socket, net::service_base& service,
-                                         net::service_locator& locator, realm_manager& realm_manager)
+                                         shared::network::account_service_ring& account_services,
+                                         realm_manager& realm_manager, connection_reaper& reaper,
+                                         std::string remote_address)
       : base_connection{std::move(socket), service}
-      , locator_{locator}
+      , strand_{io_service_}
+      , account_services_{account_services}
       , realm_manager_{realm_manager}
+      , remote_address_{std::move(remote_address)}
+      , reaper_{reaper}
     {
         router_.configure_inbound(this);
     }
 
     bool client_connection::on_data(net::data_router const& router, net::service_type service, gsl::span<uint8_t> data)
+    {
+        // The state is shared with the continuations of crypto jobs, so incoming data is handled within the strand, too
+        auto self = std::static_pointer_cast<client_connection>(shared_from_this());
+        io_service_.post(strand_.wrap([self, &router, data = std::vector<uint8_t>{data.begin(), data.end()}]() mutable {
+            if (!self->handle_data(router, data))
+                self->close();
+        }));
+
+        return true;
+    }
+
+    bool client_connection::handle_data(net::data_router const& router, gsl::span<uint8_t> data)
     {
         input_stream_.put(data);
         // clang-format off
@@ -80,6 +113,10 @@ namespace keycap::logonserver
             return false;
         }
 
+        // Authenticated connections may stay around for as long as they keep talking to us
+        if (result == shared::network::state_result::ok && std::holds_alternative<authenticated>(state_))
+            reset_deadline();
+
         return result != shared::network::state_result::abort;
     }
 
@@ -90,12 +127,19 @@ namespace keycap::logonserver
         if (status == net::link_status::Up)
         {
             logger->debug("[client_connection] New connection");
+            connected_at_ = state_entered_ = std::chrono::steady_clock::now();
             state_ = just_connected{{std::static_pointer_cast<client_connection>(shared_from_this())}};
+            reset_deadline();
         }
         else
         {
             logger->debug("[client_connection] Connection closed");
-            state_ = disconnected{{std::static_pointer_cast<client_connection>(shared_from_this())}};
+            auto self = std::static_pointer_cast<client_connection>(shared_from_this());
+            io_service_.post(strand_.wrap([self]() {
+                self->state_ = disconnected{{self}};
+                self->release_admission_ticket();
+                self->reset_deadline();
+            }));
         }
 
         return true;
@@ -107,4 +151,157 @@ namespace keycap::logonserver
         error.result = result;
         send(error.encode());
     }
+
+    void client_connection::set_admission_ticket(std::unique_ptr<admission_control::ticket> ticket)
+    {
+        std::atomic_store(&admission_ticket_, std::shared_ptr<admission_control::ticket>{std::move(ticket)});
+    }
+
+    void client_connection::release_admission_ticket()
+    {
+        std::atomic_store(&admission_ticket_, std::shared_ptr<admission_control::ticket>{});
+    }
+
+    bool client_connection::expire_deadline(uint32 generation)
+    {
+        if (generation != deadline_generation_)
+            return false;
+
+        auto logger = keycap::root::utility::get_safe_logger("connections");
+        logger->debug("[client_connection] Closing connection from {} after its deadline expired", remote_address_);
+
+        // The state may only be touched from within the strand
+        auto self = std::static_pointer_cast<client_connection>(shared_from_this());
+        io_service_.post(strand_.wrap([self, generation]() {
+            if (generation == self->deadline_generation_)
+                self->close();
+        }));
+
+        return true;
+    }
+
+    void client_connection::reset_deadline()
+    {
+        auto generation = ++deadline_generation_;
+
+        auto const& timeouts = reaper_.timeouts();
+        std::chrono::seconds timeout{0};
+        if (std::holds_alternative<just_connected>(state_))
+            timeout = timeouts.just_connected;
+        else if (std::holds_alternative<challanged>(state_) || std::holds_alternative<reconnect_challanged>(state_))
+            timeout = timeouts.challanged;
+        else if (std::holds_alternative<transferring>(state_))
+            timeout = timeouts.transferring;
+        else if (std::holds_alternative<authenticated>(state_))
+            timeout = timeouts.authenticated;
+
+        // Disconnected connections and disabled timeouts don't need a deadline
+        if (timeout.count() <= 0)
+            return;
+
+        reaper_.schedule(std::static_pointer_cast<client_connection>(shared_from_this()), generation, timeout);
+    }
+
+    void client_connection::leave_state()
+    {
+        auto now = std::chrono::steady_clock::now();
+        auto elapsed = now - state_entered_;
+        state_entered_ = now;
+
+        auto& metrics = get_login_metrics();
+        if (std::holds_alternative<just_connected>(state_))
+            metrics.just_connected.record(elapsed);
+        else if (std::holds_alternative<challanged>(state_))
+            metrics.challanged.record(elapsed);
+        else if (std::holds_alternative<transferring>(state_))
+            metrics.transferring.record(elapsed);
+        else if (std::holds_alternative<reconnect_challanged>(state_))
+            metrics.reconnect_challanged.record(elapsed);
+    }
+
+    void client_connection::enter_authenticated()
+    {
+        leave_state();
+        get_login_metrics().login.record(state_entered_ - connected_at_);
+
+        state_ = authenticated{std::static_pointer_cast<client_connection>(shared_from_this())};
+        reset_deadline();
+    }
+
+    void client_connection::request_character_counts()
+    {
+        using counts_map = std::unordered_map<uint8, uint8>;
+
+        auto locator = account_services_.by_id(account_id_);
+        if (!locator)
+        {
+            // The realm list is sent without any characters instead of waiting for an account service
+            set_character_counts(std::make_shared<counts_map const>());
+            return;
+        }
+
+        protocol::request_character_counts request;
+        request.account_id = account_id_;
+
+        auto self = std::static_pointer_cast<client_connection>(shared_from_this());
+
+        // Nor does the realm list wait for an account service that never replies. A late reply still replaces the
+        // empty counts for the realm lists requested after it
+        auto timer = std::make_shared<boost::asio::deadline_timer>(io_service_, character_counts_timeout);
+        timer->async_wait(strand_.wrap([self, timer](boost::system::error_code const& error) {
+            if (!error && !std::atomic_load(&self->character_counts_))
+                self->set_character_counts(std::make_shared<counts_map const>());
+        }));
+
+        locator->send_registered(
+            keycap::shared::network::account_service_type, request.encode(), io_service_,
+            [self, timer](net::service_type sender, net::memory_stream data) {
+                if (data.peek<protocol::shared_command>() != protocol::shared_command::reply_character_counts)
+                    return false;
+
+                auto reply = protocol::reply_character_counts::decode(data);
+
+                auto counts = std::make_shared<counts_map>();
+                for (auto& count : reply.counts)
+                    (*counts)[count.realm_id] = count.count;
+
+                // Sending the realm list touches the connection's state, which is only done from within the strand
+                self->io_service_.post(self->strand_.wrap([self, timer, counts = std::move(counts)]() mutable {
+                    timer->cancel();
+                    self->set_character_counts(std::move(counts));
+                }));
+
+                return true;
+            });
+    }
+
+    void client_connection::set_character_counts(std::shared_ptr<std::unordered_map<uint8, uint8> const> counts)
+    {
+        std::atomic_store(&character_counts_, std::move(counts));
+
+        if (realm_list_pending_.exchange(false))
+            send_realm_list();
+    }
+
+    void client_connection::send_realm_list()
+    {
+        auto list = realm_manager_.realm_list(build_);
+        auto counts = std::atomic_load(&character_counts_);
+
+        auto has_characters = [&](auto const& offset) { return counts && counts->count(offset.first); };
+        if (!std::any_of(list->character_offsets.begin(), list->character_offsets.end(), has_characters))
+        {
+            send(list->packet);
+            return;
+        }
+
+        auto packet = list->packet;
+        for (auto [realm_id, offset] : list->character_offsets)
+        {
+            if (auto count = counts->find(realm_id); count != counts->end())
+                packet.override(count->second, offset);
+        }
+
+        send(packet);
+    }
 }
@@ -17,10 +17,15 @@
 #pragma once
 
 #include "../authentication/pin_authenticator.hpp"
+#include "admission_control.hpp"
+#include "connection_reaper.hpp"
 
 #include "generated/logon.hpp"
 #include "logon_service.hpp"
+#include "streamable_file.hpp"
 
+#include <cryptography/srp6.hpp>
+#include <network/account_service_ring.hpp>
 #include <network/state_result.hpp>
 
 #include <botan/bigint.h>
@@ -31,11 +36,18 @@
 #include <keycap/root/network/service_locator.hpp>
 #include <keycap/root/network/srp6/server.hpp>
 
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <optional>
+#include <unordered_map>
 #include <variant>
 
 namespace keycap::protocol
 {
     class reply_account_data;
+    class reply_session_key;
 }
 
 namespace keycap::logonserver
@@ -48,7 +60,8 @@ namespace keycap::logonserver
 
       public:
         client_connection(boost::asio::ip::tcp::socket socket, keycap::root::network::service_base& service,
-                          keycap::root::network::service_locator& locator, realm_manager& realm_manager);
+                          shared::network::account_service_ring& account_services, realm_manager& realm_manager,
+                          connection_reaper& reaper, std::string remote_address);
 
         bool on_data(keycap::root::network::data_router const& router, keycap::root::network::service_type service,
                      gsl::span<uint8_t> data) override;
@@ -56,17 +69,31 @@ namespace keycap::logonserver
         bool on_link(keycap::root::network::data_router const& router, keycap::root::network::service_type service,
                      keycap::root::network::link_status status) override;
 
-        keycap::root::network::service_locator& service_locator()
+        shared::network::account_service_ring& account_services()
         {
-            return locator_;
+            return account_services_;
         }
 
         void send_error(protocol::grunt_result result);
 
+        std::string const& remote_address() const
+        {
+            return remote_address_;
+        }
+
+        // Holds on to the given half-open slot until the login has either succeeded or the connection is closed
+        void set_admission_ticket(std::unique_ptr<admission_control::ticket> ticket);
+
+        // Gives the half-open slot back to the admission_control
+        void release_admission_ticket();
+
+        // Closes the connection if the given deadline hasn't been re-armed since. Returns true if it has been closed
+        bool expire_deadline(uint32 generation);
+
       private:
         struct challanged_data
         {
-            std::shared_ptr<keycap::root::network::srp6::server> server;
+            std::shared_ptr<shared::cryptography::srp6::server> server;
             std::string verifier;
             keycap::root::network::srp6::compliance compliance;
 
@@ -105,9 +132,15 @@ namespace keycap::logonserver
             void on_account_reply(std::weak_ptr<client_connection> connection,
                                   protocol::reply_account_data const& reply, std::string const& account_name);
 
+            void on_session_key_reply(std::weak_ptr<client_connection> connection,
+                                      protocol::reply_session_key const& reply, std::string const& account_name);
+
             std::string name = "JustConnected";
 
           private:
+            // Asks the account service for the session key of the client's previous login
+            shared::network::state_result on_reconnect_challange(keycap::root::network::memory_stream& stream);
+
             void send_server_challange(std::shared_ptr<client_connection> conn, challanged_data const& challanged_data,
                                        keycap::root::network::srp6::compliance compliance,
                                        keycap::root::network::srp6::group_parameter const& parameter,
@@ -125,12 +158,28 @@ namespace keycap::logonserver
             std::string name = "Challanged";
             challanged_data data;
 
-          private:
-            std::tuple<Botan::BigInt, Botan::BigInt, Botan::BigInt>
-            generate_session_key_and_server_proof(std::string const& username,
-                                                  protocol::client_logon_proof const& packet);
+            // Set while the client's proof is being verified by the crypto_executor
+            bool verifying = false;
 
-            void send_proof_success(Botan::BigInt session_key, Botan::BigInt M1_S, bool send_survey);
+          private:
+            struct proof_result
+            {
+                Botan::BigInt session_key;
+                Botan::BigInt M1;
+                Botan::BigInt M1_S;
+                Botan::BigInt M2;
+            };
+
+            // Runs on the crypto_executor
+            static proof_result generate_session_key_and_server_proof(challanged_data const& data,
+                                                                      std::string const& username,
+                                                                      protocol::client_logon_proof const& packet);
+
+            // Called with an empty result if the proof couldn't be verified
+            void on_proof_verified(std::shared_ptr<client_connection> conn,
+                                   std::optional<proof_result> const& verified);
+
+            void send_proof_success(Botan::BigInt const& M2, bool send_survey);
         };
 
         // Client send its Challange and is now authenticated
@@ -145,32 +194,107 @@ namespace keycap::logonserver
             void handle_survey_result(protocol::survey_result packet);
         };
 
+        // Feeds the given data to the current state. Returns false if the connection has to be closed. Runs on strand_
+        bool handle_data(keycap::root::network::data_router const& router, gsl::span<uint8_t> data);
+
+        // Records the time spent in the current state. Must be called right before switching to the next one
+        void leave_state();
+
+        // Arms the deadline of the current state, replacing the previous one. Must be called right after switching to
+        // the next state
+        void reset_deadline();
+
+        // Switches to the authenticated state and records how long the login took
+        void enter_authenticated();
+
+        // Asks the account service for the number of characters the user has on each realm. Falls back to no
+        // characters at all if there is no account service or it doesn't reply in time
+        void request_character_counts();
+
+        // Stores the given character counts and sends the realm list if the client is waiting for it. Runs on strand_
+        void set_character_counts(std::shared_ptr<std::unordered_map<uint8, uint8> const> counts);
+
+        // Sends the realm list with the user's character counts patched in
+        void send_realm_list();
+
         // We're sending some data (patches, surveys, etc.) to the client
         struct transferring : public state
         {
-            transferring(std::weak_ptr<client_connection> connection);
+            transferring(std::weak_ptr<client_connection> connection, std::shared_ptr<streamable_file const> file);
 
             shared::network::state_result on_data(keycap::root::network::data_router const& router,
                                                   keycap::root::network::memory_stream& stream);
 
-            std::vector<uint8> data;
+            std::shared_ptr<streamable_file const> file;
+            uint64 offset = 0;
+            bool sending = false;
+            // Set while a chunk is being written straight to the socket, bypassing the send queue
+            bool in_flight = false;
+            // Set if the client cancelled the transfer while a chunk was in flight
+            bool cancelled = false;
 
             std::string name = "Transferring";
 
           private:
-            void send(keycap::root::network::memory_stream const& stream);
+            // Sends the next chunk. The one after it is sent once this one has been written
+            static void send_next_chunk(std::weak_ptr<client_connection> connection);
+
+            // Sends the next chunk or, if the transfer has been cancelled in the meantime, finally leaves this state
+            static void on_chunk_written(std::weak_ptr<client_connection> connection,
+                                         boost::system::error_code const& error);
+        };
+
+        // Reconnect challange was send to the client and we're waiting for it to prove that it still knows the session
+        // key of its previous login
+        struct reconnect_challanged : public state
+        {
+            reconnect_challanged(std::weak_ptr<client_connection> connection, Botan::BigInt session_key);
+
+            shared::network::state_result on_data(keycap::root::network::data_router const& router,
+                                                  keycap::root::network::memory_stream& stream);
+
+            std::string name = "ReconnectChallanged";
+            Botan::BigInt session_key;
+            std::array<uint8, 16> challange_data;
         };
 
         pin_authenticator authenticator_;
 
-        std::variant<disconnected, just_connected, challanged, transferring, authenticated> state_;
+        std::chrono::steady_clock::time_point connected_at_;
+        std::chrono::steady_clock::time_point state_entered_;
+
+        // New states have to be appended as some of them are addressed by index
+        std::variant<disconnected, just_connected, challanged, transferring, authenticated, reconnect_challanged>
+            state_;
 
         keycap::root::network::memory_stream input_stream_;
 
-        keycap::root::network::service_locator& locator_;
+        // Incoming data and the continuations of crypto jobs are handled on this strand
+        boost::asio::io_service::strand strand_;
+
+        shared::network::account_service_ring& account_services_;
 
         std::string account_name_;
+        uint32 account_id_ = 0;
+
+        // The client's build as sent with its logon challange
+        uint16 build_ = 0;
+
+        // Number of characters on each realm. Fetched once after a successful login and only ever accessed through
+        // std::atomic_load/std::atomic_store
+        std::shared_ptr<std::unordered_map<uint8, uint8> const> character_counts_;
+        // Set if the client requested the realm list before its character counts arrived
+        std::atomic_bool realm_list_pending_{false};
 
         realm_manager& realm_manager_;
+
+        std::string remote_address_;
+
+        connection_reaper& reaper_;
+        // Incremented whenever the deadline is re-armed so older deadlines can be told apart
+        std::atomic_uint32_t deadline_generation_{0};
+
+        // Half-open slot taken by this connection while it's logging in. Only ever accessed through std::atomic_store
+        std::shared_ptr<admission_control::ticket> admission_ticket_;
     };
 }
\ No newline at end of file
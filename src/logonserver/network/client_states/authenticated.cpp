@@ -67,24 +67,16 @@ namespace keycap::logonserver
 
         auto conn = connection.lock();
 
-        protocol::server_realm_list outPacket;
-
-        conn->realm_manager_.iterate([&outPacket](keycap::protocol::realm_info const& realm_data) {
-            auto& data = outPacket.data.emplace_back(protocol::realm_list_data{});
-            data.type = realm_data.type;
-            data.locked = realm_data.locked;
-            data.realm_flags = realm_data.realm_flags;
-            data.name = realm_data.name;
-            data.ip = realm_data.ip;
-            data.population = realm_data.population;
-            data.num_characters = 0;
-            data.category = realm_data.category;
-            data.id = realm_data.id;
-        });
-
-        outPacket.unk = 0xC01A;
-
-        conn->send(outPacket.encode());
+        if (!std::atomic_load(&conn->character_counts_))
+        {
+            // The character counts will send the realm list once they arrive. Check again in case they arrived in
+            // the meantime; whoever resets the flag sends the list
+            conn->realm_list_pending_ = true;
+            if (!std::atomic_load(&conn->character_counts_) || !conn->realm_list_pending_.exchange(false))
+                return;
+        }
+
+        conn->send_realm_list();
     }
 
     void client_connection::authenticated::handle_survey_result(protocol::survey_result packet)
@@ -98,7 +90,10 @@ namespace keycap::logonserver
         out_packet.account_name = conn->account_name_;
         out_packet.telemetry = packet.data;
 
-        if (packet.error == 0)
-            conn->service_locator().send_to(shared_net::account_service_type, out_packet.encode());
+        if (packet.error != 0)
+            return;
+
+        if (auto locator = conn->account_services().by_name(conn->account_name_))
+            locator->send_to(shared_net::account_service_type, out_packet.encode());
     }
 }
\ No newline at end of file
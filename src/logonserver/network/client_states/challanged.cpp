@@ -15,24 +15,32 @@
 */
 
 #include "../../authentication/pin_authenticator.hpp"
+#include "../../login_metrics.hpp"
 #include "../client_connection.hpp"
 
 #include <keycap/root/cryptography/OTP.hpp>
-#include <keycap/root/network/srp6/server.hpp>
 #include <keycap/root/network/srp6/utility.hpp>
 
+#include <cryptography/crypto_executor.hpp>
+#include <cryptography/srp6.hpp>
 #include <generated/shared_protocol.hpp>
 
 #include <botan/base32.h>
 
 #include <spdlog/spdlog.h>
 
+#include <algorithm>
+
 namespace net = keycap::root::network;
 namespace shared_net = keycap::shared::network;
 namespace protocol = keycap::protocol;
+namespace srp6 = keycap::shared::cryptography::srp6;
 
 namespace HOTP = keycap::root::cryptography::HOTP;
 
+extern keycap::shared::cryptography::crypto_executor& get_crypto_executor();
+extern keycap::logonserver::login_metrics& get_login_metrics();
+
 namespace keycap::logonserver
 {
     client_connection::challanged::challanged(std::weak_ptr<client_connection> connection, challanged_data const& data)
@@ -52,29 +60,36 @@ namespace keycap::logonserver
         auto logger = keycap::root::utility::get_safe_logger("connections");
         logger->debug("[client_connection] Updating session key of {} to {}", update.account_name, update.session_key);
 
-        connection->service_locator().send_to(shared_net::account_service_type, update.encode());
+        if (auto locator = connection->account_services().by_name(account_name))
+            locator->send_to(shared_net::account_service_type, update.encode());
     }
 
-    std::tuple<Botan::BigInt, Botan::BigInt, Botan::BigInt>
-    client_connection::challanged::generate_session_key_and_server_proof(std::string const& username,
+    client_connection::challanged::proof_result
+    client_connection::challanged::generate_session_key_and_server_proof(challanged_data const& data,
+                                                                         std::string const& username,
                                                                          protocol::client_logon_proof const& packet)
     {
-        Botan::BigInt A{packet.A.data(), 32};
-        Botan::BigInt M1{packet.M1.data(), 20};
-        auto session_key = data.server->session_key(A);
+        proof_result result;
+
+        auto A = srp6::from_little_endian(packet.A.data(), packet.A.size());
+        result.M1 = srp6::from_little_endian(packet.M1.data(), packet.M1.size());
+        result.session_key = data.server->session_key(A);
 
-        auto M1_S = net::srp6::generate_client_proof(data.server->prime(), data.server->generator(), data.user_salt,
-                                                     username, A, data.server->public_ephemeral_value(), session_key,
-                                                     data.server->compliance_mode());
+        if (result.session_key.is_zero())
+            return result;
 
-        return std::make_tuple(std::move(session_key), std::move(M1), std::move(M1_S));
+        result.M1_S = srp6::client_proof(data.server->prime(), data.server->generator(), data.user_salt, username, A,
+                                         data.server->public_ephemeral_value(), result.session_key);
+        result.M2 = data.server->proof(result.M1_S, result.session_key);
+
+        return result;
     }
 
-    void client_connection::challanged::send_proof_success(Botan::BigInt session_key, Botan::BigInt M1_S,
-                                                           bool send_survey)
+    void client_connection::challanged::send_proof_success(Botan::BigInt const& M2, bool send_survey)
     {
         protocol::server_logon_proof outPacket;
-        outPacket.M2 = net::srp6::to_array<20>(data.server->proof(M1_S, session_key), data.server->compliance_mode());
+        auto proof = srp6::to_little_endian(M2, outPacket.M2.size());
+        std::copy(proof.begin(), proof.end(), outPacket.M2.begin());
         outPacket.account_flags = data.account_flags;
         outPacket.num_account_messages = 0;
         // TODO: implement proper survey selection. See https://github.com/DennisWG/KeycapEmu/issues/20
@@ -115,7 +130,8 @@ namespace keycap::logonserver
     shared::network::state_result client_connection::challanged::on_data(net::data_router const& router,
                                                                          net::memory_stream& stream)
     {
-        if (stream.size() < protocol::client_logon_proof::expected_size)
+        // Don't accept another proof before the current one has been verified
+        if (verifying || stream.size() < protocol::client_logon_proof::expected_size)
             return shared::network::state_result::incomplete_data;
 
         if (stream.peek<protocol::command>() != protocol::command::proof)
@@ -130,6 +146,7 @@ namespace keycap::logonserver
         auto totp_secret = Botan::base32_encode(reinterpret_cast<uint8_t*>(secret.data()), secret.size());
 
         auto conn = connection.lock();
+        get_login_metrics().client_proof.record(std::chrono::steady_clock::now() - conn->state_entered_);
 
         if (packet.pin_response)
         {
@@ -140,25 +157,70 @@ namespace keycap::logonserver
             }
         }
 
-        auto [session_key, M1, M1_S] = generate_session_key_and_server_proof(conn->account_name_, packet);
+        verifying = true;
+
+        auto job = [data = data, username = conn->account_name_, packet = std::move(packet)] {
+            return generate_session_key_and_server_proof(data, username, packet);
+        };
+
+        auto continuation = [connection = connection,
+                             posted = std::chrono::steady_clock::now()](std::optional<proof_result> result) {
+            get_login_metrics().proof_verification.record(std::chrono::steady_clock::now() - posted);
 
-        if (M1_S != M1)
+            auto conn = connection.lock();
+            if (!conn)
+                return;
+
+            if (auto state = std::get_if<challanged>(&conn->state_))
+                state->on_proof_verified(conn, result);
+        };
+
+        if (!get_crypto_executor().post(conn, conn->strand_, std::move(job), std::move(continuation)))
         {
-            return login_error("[client_connection] User {} tried to log in with incorrect login info!", conn,
-                               protocol::grunt_result::unknown_account, conn->account_name_);
+            verifying = false;
+            return login_error("[client_connection] Crypto queue is full! Rejecting login of user {}", conn,
+                               protocol::grunt_result::db_busy, conn->account_name_);
         }
 
-        update_session_key(conn, conn->account_name_, session_key);
+        return shared::network::state_result::ok;
+    }
+
+    void client_connection::challanged::on_proof_verified(std::shared_ptr<client_connection> conn,
+                                                          std::optional<proof_result> const& verified)
+    {
+        verifying = false;
+
+        if (!verified)
+        {
+            login_error("[client_connection] Couldn't verify the proof of user {}", conn,
+                        protocol::grunt_result::db_busy, conn->account_name_);
+            return;
+        }
+
+        auto const& result = *verified;
+        if (result.session_key.is_zero() || result.M1_S != result.M1)
+        {
+            login_error("[client_connection] User {} tried to log in with incorrect login info!", conn,
+                        protocol::grunt_result::unknown_account, conn->account_name_);
+            return;
+        }
+
+        update_session_key(conn, conn->account_name_, result.session_key);
+        conn->release_admission_ticket();
+        conn->request_character_counts();
 
         // TODO: implement proper survey selection. See https://github.com/DennisWG/KeycapEmu/issues/20
-        bool constexpr send_survey = true;
-        send_proof_success(session_key, M1_S, send_survey);
+        auto survey = get_streamable_file("Survey.mpq");
+        bool const send_survey = survey != nullptr;
+        send_proof_success(result.M2, send_survey);
 
         if (send_survey)
-            conn->state_.emplace<3>(std::weak_ptr<client_connection>{connection});
+        {
+            conn->leave_state();
+            conn->state_.emplace<3>(std::weak_ptr<client_connection>{connection}, std::move(survey));
+            conn->reset_deadline();
+        }
         else
-            conn->state_ = authenticated{connection};
-
-        return shared::network::state_result::ok;
+            conn->enter_authenticated();
     }
-}
\ No newline at end of file
+}
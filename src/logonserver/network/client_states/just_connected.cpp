@@ -15,7 +15,11 @@
 */
 
 #include "../client_connection.hpp"
+#include "../../account_cache.hpp"
+#include "../../login_metrics.hpp"
 
+#include <cryptography/ephemeral_pool.hpp>
+#include <cryptography/random.hpp>
 #include <generated/shared_protocol.hpp>
 
 #include <keycap/root/network/srp6/utility.hpp>
@@ -25,6 +29,10 @@
 namespace net = keycap::root::network;
 namespace shared_net = keycap::shared::network;
 
+extern keycap::shared::cryptography::srp6::ephemeral_pool& get_ephemeral_pool();
+extern keycap::logonserver::account_cache& get_account_cache();
+extern keycap::logonserver::login_metrics& get_login_metrics();
+
 namespace keycap::logonserver
 {
     shared::network::state_result client_connection::just_connected::on_data(net::data_router const& router,
@@ -36,6 +44,10 @@ namespace keycap::logonserver
         if (stream.size() < header_size || stream.peek<uint16>(error_position) > (stream.size() - header_size))
             return shared::network::state_result::incomplete_data;
 
+        // Clients that still know their session key skip the SRP6 exchange
+        if (stream.peek<protocol::command>() == protocol::command::reconnect_challange)
+            return on_reconnect_challange(stream);
+
         if (stream.peek<protocol::command>() != protocol::command::challange)
             return shared::network::state_result::abort;
 
@@ -47,22 +59,124 @@ namespace keycap::logonserver
         if (packet.cmd != protocol::command::challange)
             return shared::network::state_result::abort;
 
+        auto conn = connection.lock();
+        conn->build_ = packet.build;
+
+        protocol::reply_account_data cached{};
+        if (get_account_cache().find(packet.account_name, cached.data))
+        {
+            // Answer asynchronously just like the account service would as on_account_reply replaces this state
+            conn->io_service_.post(conn->strand_.wrap([self = conn, cached, account_name = packet.account_name] {
+                if (auto state = std::get_if<just_connected>(&self->state_))
+                    state->on_account_reply(self, cached, account_name);
+            }));
+
+            return shared::network::state_result::ok;
+        }
+
+        auto locator = conn->account_services().by_name(packet.account_name);
+        if (!locator)
+        {
+            logger->error("[client_connection] No account service available");
+            conn->send_error(protocol::grunt_result::db_busy);
+            return shared::network::state_result::abort;
+        }
+
         protocol::request_account_data request;
         request.account_name = packet.account_name;
 
+        locator->send_registered(
+            shared_net::account_service_type, request.encode(), conn->io_service_,
+            [account_name = packet.account_name, self = conn,
+             requested = std::chrono::steady_clock::now()](net::service_type sender, net::memory_stream data) {
+                get_login_metrics().account_lookup.record(std::chrono::steady_clock::now() - requested);
+
+                auto reply = protocol::reply_account_data::decode(data);
+                // A failed lookup mustn't be remembered as an account that doesn't exist
+                if (!reply.failed)
+                    get_account_cache().insert(account_name, reply.data);
+
+                // The state may only be touched from within the strand
+                self->io_service_.post(self->strand_.wrap([self, reply, account_name] {
+                    if (auto state = std::get_if<just_connected>(&self->state_))
+                        state->on_account_reply(self, reply, account_name);
+                }));
+                return true;
+            });
+
+        return shared::network::state_result::ok;
+    }
+
+    void send_reconnect_error(std::shared_ptr<client_connection> const& connection, protocol::grunt_result result)
+    {
+        protocol::server_reconnect_challange error;
+        error.error = result;
+        connection->send(error.encode());
+    }
+
+    shared::network::state_result client_connection::just_connected::on_reconnect_challange(net::memory_stream& stream)
+    {
+        auto packet{protocol::client_reconnect_challange::decode(stream)};
+
+        auto logger = keycap::root::utility::get_safe_logger("connections");
+        logger->debug("[client_connection] {}", packet.to_string());
+
         auto conn = connection.lock();
+        conn->build_ = packet.build;
+
+        auto locator = conn->account_services().by_name(packet.account_name);
+        if (!locator)
+        {
+            logger->error("[client_connection] No account service available");
+            send_reconnect_error(conn, protocol::grunt_result::db_busy);
+            return shared::network::state_result::abort;
+        }
+
+        protocol::request_session_key request;
+        request.account_name = packet.account_name;
 
-        conn->service_locator().send_registered(
+        locator->send_registered(
             shared_net::account_service_type, request.encode(), conn->io_service_,
-            [&, account_name = packet.account_name, self = conn](net::service_type sender, net::memory_stream data) {
-                auto reply = protocol::reply_account_data::decode(data);
-                on_account_reply(self, reply, account_name);
+            [account_name = packet.account_name, self = conn](net::service_type sender, net::memory_stream data) {
+                if (data.peek<protocol::shared_command>() != protocol::shared_command::reply_session_key)
+                    return false;
+
+                auto reply = protocol::reply_session_key::decode(data);
+                self->io_service_.post(self->strand_.wrap([self, reply, account_name] {
+                    if (auto state = std::get_if<just_connected>(&self->state_))
+                        state->on_session_key_reply(self, reply, account_name);
+                }));
+
                 return true;
             });
 
         return shared::network::state_result::ok;
     }
 
+    void client_connection::just_connected::on_session_key_reply(std::weak_ptr<client_connection> connection,
+                                                                 protocol::reply_session_key const& reply,
+                                                                 std::string const& account_name)
+    {
+        auto conn = connection.lock();
+        if (!conn)
+            return;
+
+        if (!reply.session_key)
+        {
+            auto logger = keycap::root::utility::get_safe_logger("connections");
+            logger->info("User {} tried to reconnect without having logged in before!", account_name);
+            send_reconnect_error(conn, protocol::grunt_result::unknown_account);
+            return;
+        }
+
+        conn->account_name_ = account_name;
+        conn->account_id_ = reply.account_id;
+
+        conn->leave_state();
+        conn->state_.emplace<reconnect_challanged>(conn, Botan::BigInt{*reply.session_key});
+        conn->reset_deadline();
+    }
+
     void client_connection::just_connected::on_account_reply(std::weak_ptr<client_connection> connection,
                                                              protocol::reply_account_data const& reply,
                                                              std::string const& account_name)
@@ -74,6 +188,13 @@ namespace keycap::logonserver
 
         auto logger = keycap::root::utility::get_safe_logger("connections");
 
+        if (reply.failed)
+        {
+            conn->send_error(protocol::grunt_result::db_busy);
+            logger->error("[client_connection] Couldn't look up user {}", account_name);
+            return;
+        }
+
         if (!reply.data)
         {
             conn->send_error(protocol::grunt_result::unknown_account);
@@ -88,16 +209,22 @@ namespace keycap::logonserver
         Botan::BigInt salt{reply.data->salt};
 
         conn->account_name_ = account_name;
+        conn->account_id_ = reply.data->account_id;
 
         challanged_data challanged_data;
-        challanged_data.server = std::make_shared<net::srp6::server>(parameter, verifier, compliance);
+        auto& pool = get_ephemeral_pool();
+        challanged_data.server = std::make_shared<shared::cryptography::srp6::server>(
+            Botan::BigInt{parameter.N}, Botan::BigInt{parameter.g}, verifier, pool.take());
+        challanged_data.compliance = compliance;
         challanged_data.verifier = reply.data->verifier;
         challanged_data.user_salt = salt;
-        challanged_data.checksum_salt = Botan::AutoSeeded_RNG().random_vec(16);
+        challanged_data.checksum_salt = shared::cryptography::random_bytes(16);
         challanged_data.account_flags = static_cast<protocol::account_flag>(reply.data->flags);
 
         send_server_challange(conn, challanged_data, compliance, parameter, salt, reply.data->security_options);
+        conn->leave_state();
         conn->state_ = challanged{conn, challanged_data};
+        conn->reset_deadline();
     }
 
     void client_connection::just_connected::send_server_challange(std::shared_ptr<client_connection> conn,
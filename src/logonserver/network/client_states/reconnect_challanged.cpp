@@ -0,0 +1,84 @@
+/*
+    Copyright 2018-2019 KeycapEmu
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "../client_connection.hpp"
+
+#include <cryptography/random.hpp>
+
+#include <keycap/root/network/srp6/utility.hpp>
+
+#include <botan/sha160.h>
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+
+namespace net = keycap::root::network;
+
+namespace keycap::logonserver
+{
+    client_connection::reconnect_challanged::reconnect_challanged(std::weak_ptr<client_connection> connection,
+                                                                  Botan::BigInt session_key)
+      : state{connection}
+      , session_key{std::move(session_key)}
+      , challange_data{shared::cryptography::random_array<16>()}
+    {
+        protocol::server_reconnect_challange packet;
+        packet.challange_data = challange_data;
+
+        connection.lock()->send(packet.encode());
+    }
+
+    shared::network::state_result client_connection::reconnect_challanged::on_data(net::data_router const& router,
+                                                                                  net::memory_stream& stream)
+    {
+        if (stream.size() < protocol::client_reconnect_proof::expected_size)
+            return shared::network::state_result::incomplete_data;
+
+        if (stream.peek<protocol::command>() != protocol::command::reconnect_proof)
+            return shared::network::state_result::abort;
+
+        auto packet = protocol::client_reconnect_proof::decode(stream);
+        auto conn = connection.lock();
+
+        // A single hash instead of SRP6's modular exponentiations, so there's no need for the crypto_executor
+        Botan::SHA_1 sha;
+        sha.update(conn->account_name_);
+        sha.update(packet.R1.data(), packet.R1.size());
+        sha.update(challange_data.data(), challange_data.size());
+        sha.update(net::srp6::encode_flip(session_key));
+        auto digest = sha.final();
+
+        if (!std::equal(digest.begin(), digest.end(), packet.R2.begin()))
+        {
+            auto logger = keycap::root::utility::get_safe_logger("connections");
+            logger->info("[client_connection] User {} tried to reconnect with an invalid session key!",
+                         conn->account_name_);
+
+            protocol::server_reconnect_proof error;
+            error.result = protocol::grunt_result::unknown_account;
+            conn->send(error.encode());
+            return shared::network::state_result::ok;
+        }
+
+        conn->send(protocol::server_reconnect_proof{}.encode());
+        conn->release_admission_ticket();
+        conn->request_character_counts();
+        conn->enter_authenticated();
+
+        return shared::network::state_result::ok;
+    }
+}
@@ -16,37 +16,27 @@
 
 #include "../client_connection.hpp"
 
-#include <keycap/root/utility/md5.hpp>
-
 #include <spdlog/spdlog.h>
 
-#include <filesystem>
-#include <fstream>
+#include <boost/asio/write.hpp>
+
+#include <algorithm>
+#include <array>
+#include <memory>
 
 namespace net = keycap::root::network;
 
 namespace keycap::logonserver
 {
-    client_connection::transferring::transferring(std::weak_ptr<client_connection> connection)
+    client_connection::transferring::transferring(std::weak_ptr<client_connection> connection,
+                                                  std::shared_ptr<streamable_file const> file)
       : state{connection}
+      , file{std::move(file)}
     {
         protocol::xfer_initiate packet;
-
-        // TODO: Implement proper file handling. See https://github.com/DennisWG/KeycapEmu/issues/21
-        constexpr auto path = "Survey.mpq";
-        auto size = std::filesystem::file_size(path);
-
-        std::ifstream file{path, std::ios::binary};
-
-        data.resize(static_cast<size_t>(size), 0);
-        file.read(reinterpret_cast<char*>(data.data()), size);
-
-        if (!file.good())
-            throw "Something went wrong!";
-
         packet.action = "Survey";
-        packet.filesize = static_cast<uint64>(size);
-        packet.md5_checksum = root::utility::md5(data);
+        packet.filesize = this->file->size();
+        packet.md5_checksum = this->file->md5();
 
         connection.lock()->send(packet.encode());
     }
@@ -56,6 +46,11 @@ namespace keycap::logonserver
     {
         auto logger = keycap::root::utility::get_safe_logger("connections");
 
+        // Anything sent after a cancel is held back until the in-flight chunk has been written and the connection
+        // has left this state
+        if (cancelled)
+            return shared::network::state_result::incomplete_data;
+
         auto command = stream.peek<protocol::command>();
         auto conn = connection.lock();
 
@@ -66,18 +61,40 @@ namespace keycap::logonserver
             // Or, when Survey.MPQ already exists locally
             case protocol::command::xfer_cancel:
                 stream.clear();
-                conn->state_ = authenticated{connection};
+                // Nothing else may be sent while a chunk is still being written, so we wait for it to complete first
+                if (in_flight)
+                    cancelled = true;
+                else
+                    conn->enter_authenticated();
                 return shared::network::state_result::ok;
 
             case protocol::command::xfer_accept:
                 stream.clear();
-                send({data.begin(), data.end()});
+                if (!sending)
+                {
+                    sending = true;
+                    send_next_chunk(connection);
+                }
                 break;
 
             case protocol::command::xfer_resume:
-                // TODO: https://github.com/DennisWG/KeycapEmu/issues/6
-                stream.clear();
-                break;
+            {
+                if (stream.size() < protocol::client_xfer_resume::expected_size)
+                    return shared::network::state_result::incomplete_data;
+
+                auto packet = protocol::client_xfer_resume::decode(stream);
+                if (sending || packet.offset > file->size())
+                {
+                    logger->debug("[client_connection] Received invalid xfer_resume at offset {} of {}", packet.offset,
+                                  file->size());
+                    return shared::network::state_result::abort;
+                }
+
+                offset = packet.offset;
+                sending = true;
+                send_next_chunk(connection);
+            }
+            break;
 
             default:
                 logger->debug("Received unexpected command {}({})", command.to_string(), command);
@@ -87,29 +104,70 @@ namespace keycap::logonserver
         return shared::network::state_result::ok;
     }
 
-    void client_connection::transferring::send(keycap::root::network::memory_stream const& stream)
+    void client_connection::transferring::send_next_chunk(std::weak_ptr<client_connection> connection)
     {
         auto conn = connection.lock();
+        if (!conn)
+            return;
+
+        // The client might have cancelled the transfer in the meantime
+        auto state = std::get_if<transferring>(&conn->state_);
+        if (!state)
+            return;
 
-        if (!stream.has_data_remaining())
+        if (state->offset >= state->file->size())
         {
-            conn->state_ = authenticated{connection};
+            conn->enter_authenticated();
             return;
         }
 
-        auto callback = [this, stream = stream, connection = conn]() mutable {
-            protocol::xfer_data packet;
+        size_t constexpr max_chunk_size = 65535;
+        auto chunk = state->file->chunk(state->offset, max_chunk_size);
+        state->offset += chunk.size();
+
+        // The chunk is sent straight out of the mapped file instead of being copied into an xfer_data packet
+        auto size = static_cast<uint16>(chunk.size());
+        auto header = std::make_shared<std::array<uint8, 3>>(std::array<uint8, 3>{
+            static_cast<uint8>(protocol::command::xfer_data), static_cast<uint8>(size), static_cast<uint8>(size >> 8)});
+
+        std::array<boost::asio::const_buffer, 2> buffers{boost::asio::buffer(*header),
+                                                         boost::asio::buffer(chunk.data(), chunk.size())};
+
+        // Only one chunk is in flight at a time. The next one is sent once this one has been written, so a large file
+        // never piles up in the send queue and other connections' work gets interleaved between the chunks
+        state->in_flight = true;
+        boost::asio::async_write(conn->socket_, buffers,
+                                 conn->strand_.wrap([connection, header, file = state->file](
+                                                        boost::system::error_code const& error, size_t bytes_written) {
+                                     on_chunk_written(connection, error);
+                                 }));
+    }
+
+    void client_connection::transferring::on_chunk_written(std::weak_ptr<client_connection> connection,
+                                                           boost::system::error_code const& error)
+    {
+        auto conn = connection.lock();
+        if (!conn)
+            return;
+
+        auto state = std::get_if<transferring>(&conn->state_);
+        if (!state)
+            return;
 
-            size_t constexpr max_packet_size = 65535;
-            auto size = std::min(stream.size(), max_packet_size);
+        state->in_flight = false;
+        if (error)
+            return;
 
-            packet.chunk.resize(size);
-            stream.write_to(packet.chunk.begin(), size);
+        if (!state->cancelled)
+        {
+            send_next_chunk(connection);
+            return;
+        }
 
-            connection->send(packet.encode());
-            send(stream);
-        };
+        conn->enter_authenticated();
 
-        conn->io_service_.post(callback);
+        // Handle whatever the client sent while we were waiting for the chunk
+        if (conn->input_stream_.size() > 0 && !conn->handle_data(conn->router_, {}))
+            conn->close();
     }
-}
\ No newline at end of file
+}
@@ -0,0 +1,96 @@
+/*
+    Copyright 2018-2019 KeycapEmu
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "connection_reaper.hpp"
+#include "client_connection.hpp"
+
+#include <vector>
+
+namespace keycap::logonserver
+{
+    connection_reaper::connection_reaper(boost::asio::io_service& io_service, connection_timeouts const& timeouts)
+      : timeouts_{timeouts}
+      , timer_{io_service}
+      , started_{clock::now()}
+    {
+        if (timeouts_.resolution.count() <= 0)
+            timeouts_.resolution = std::chrono::milliseconds{100};
+    }
+
+    void connection_reaper::start()
+    {
+        schedule_tick();
+    }
+
+    void connection_reaper::stop()
+    {
+        boost::system::error_code ignored;
+        timer_.cancel(ignored);
+    }
+
+    void connection_reaper::schedule(std::weak_ptr<client_connection> connection, uint32 generation,
+                                     clock::duration timeout)
+    {
+        // Round up so a deadline never expires early
+        auto expires = tick_of(clock::now() + timeout) + 1;
+
+        std::lock_guard<std::mutex> lock{mutex_};
+        wheel_.schedule(expires, deadline{std::move(connection), generation});
+    }
+
+    size_t connection_reaper::pending() const
+    {
+        std::lock_guard<std::mutex> lock{mutex_};
+        return wheel_.size();
+    }
+
+    void connection_reaper::schedule_tick()
+    {
+        timer_.expires_from_now(boost::posix_time::milliseconds{timeouts_.resolution.count()});
+        timer_.async_wait([this](boost::system::error_code const& error) {
+            if (error)
+                return;
+
+            on_tick();
+            schedule_tick();
+        });
+    }
+
+    void connection_reaper::on_tick()
+    {
+        std::vector<deadline> expired;
+        {
+            std::lock_guard<std::mutex> lock{mutex_};
+            wheel_.advance(tick_of(clock::now()), [&expired](deadline& entry) {
+                if (!entry.connection.expired())
+                    expired.push_back(std::move(entry));
+            });
+        }
+
+        // Closing happens outside of the lock as it may re-arm other deadlines
+        for (auto& deadline : expired)
+        {
+            auto connection = deadline.connection.lock();
+            if (connection && connection->expire_deadline(deadline.generation))
+                ++reaped_;
+        }
+    }
+
+    uint64 connection_reaper::tick_of(clock::time_point time) const
+    {
+        return static_cast<uint64>((time - started_) / timeouts_.resolution);
+    }
+}
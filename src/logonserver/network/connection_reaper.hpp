@@ -0,0 +1,111 @@
+/*
+    Copyright 2018-2019 KeycapEmu
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#pragma once
+
+#include "timer_wheel.hpp"
+
+#include <keycap/root/types.hpp>
+
+#include <boost/asio/deadline_timer.hpp>
+#include <boost/asio/io_service.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+
+namespace keycap::logonserver
+{
+    class client_connection;
+
+    struct connection_timeouts
+    {
+        // Time a connection has to send its logon challange
+        std::chrono::seconds just_connected{10};
+
+        // Time a connection has to answer the server's challange
+        std::chrono::seconds challanged{10};
+
+        // Time a connection has to finish a file transfer
+        std::chrono::seconds transferring{120};
+
+        // Time an authenticated connection may stay silent
+        std::chrono::seconds authenticated{300};
+
+        // Length of a single tick of the timer wheel. Deadlines may be exceeded by up to this much
+        std::chrono::milliseconds resolution{100};
+    };
+
+    // Closes connections that stay in a state for longer than they're allowed to.
+    // All deadlines share a single timer_wheel and a single asio timer. Re-arming a connection's deadline doesn't
+    // remove the old one from the wheel; the old one is simply ignored once it expires
+    class connection_reaper
+    {
+        using clock = std::chrono::steady_clock;
+
+      public:
+        connection_reaper(boost::asio::io_service& io_service, connection_timeouts const& timeouts);
+
+        // Starts ticking the wheel
+        void start();
+
+        // Stops ticking the wheel. Deadlines that expire afterwards won't close their connections anymore
+        void stop();
+
+        // Closes the given connection once the given timeout has passed, unless the connection's deadline has been
+        // re-armed in the meantime
+        void schedule(std::weak_ptr<client_connection> connection, uint32 generation, clock::duration timeout);
+
+        connection_timeouts const& timeouts() const
+        {
+            return timeouts_;
+        }
+
+        // Returns the number of connections that have been closed due to an expired deadline
+        uint64 reaped() const
+        {
+            return reaped_;
+        }
+
+        // Returns the number of deadlines, including re-armed ones, that haven't expired yet
+        size_t pending() const;
+
+      private:
+        struct deadline
+        {
+            std::weak_ptr<client_connection> connection;
+            uint32 generation;
+        };
+
+        void schedule_tick();
+
+        void on_tick();
+
+        // Returns the tick during which the given time point lies
+        uint64 tick_of(clock::time_point time) const;
+
+        connection_timeouts timeouts_;
+
+        boost::asio::deadline_timer timer_;
+        clock::time_point started_;
+
+        mutable std::mutex mutex_;
+        timer_wheel<deadline> wheel_;
+
+        std::atomic_uint64_t reaped_{0};
+    };
+}
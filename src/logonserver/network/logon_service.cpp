@@ -15,17 +15,47 @@
 */
 
 #include "logon_service.hpp"
+#include "admission_control.hpp"
 #include "client_connection.hpp"
+#include "connection_reaper.hpp"
+
+#include <spdlog/spdlog.h>
 
 namespace keycap::logonserver
 {
     bool logon_service::on_new_connection(SharedHandler handler)
     {
+        // make_handler didn't create a connection for a banned address
+        if (!handler)
+            return false;
+
+        // Reject excess connections before they cost us an account service round trip and an SRP6 challange
+        auto ticket = admission_.admit(handler->remote_address());
+        if (!ticket)
+        {
+            auto logger = keycap::root::utility::get_safe_logger("connections");
+            logger->debug("[logon_service] Rejected connection from {}", handler->remote_address());
+            return false;
+        }
+
+        handler->set_admission_ticket(std::move(ticket));
         return true;
     }
 
     logon_service::SharedHandler logon_service::make_handler(boost::asio::ip::tcp::socket socket)
     {
-        return std::make_shared<client_connection>(std::move(socket), *this, locator_, realm_manager_);
+        boost::system::error_code error;
+        auto address = socket.remote_endpoint(error).address();
+
+        // Banned networks don't get anything but a closed socket, so there's no need to construct a connection first
+        if (!error && ip_bans_.banned(address))
+        {
+            auto logger = keycap::root::utility::get_safe_logger("connections");
+            logger->debug("[logon_service] Rejected connection from banned address {}", address.to_string());
+            return nullptr;
+        }
+
+        return std::make_shared<client_connection>(std::move(socket), *this, account_services_, realm_manager_, reaper_,
+                                                   address.to_string());
     }
 }
\ No newline at end of file
@@ -16,34 +16,46 @@
 
 #pragma once
 
+#include <network/account_service_ring.hpp>
+#include <network/ip_ban_list.hpp>
 #include <network/services.hpp>
 
 #include <keycap/root/network/service.hpp>
-#include <keycap/root/network/service_locator.hpp>
 
 #include <memory>
 
 namespace keycap::logonserver
 {
+    class admission_control;
     class client_connection;
+    class connection_reaper;
     class realm_manager;
 
     class logon_service : public keycap::root::network::service<client_connection>
     {
       public:
-        logon_service(int thread_count, keycap::root::network::service_locator& locator, realm_manager& realm_manager)
+        logon_service(int thread_count, shared::network::account_service_ring& account_services,
+                      realm_manager& realm_manager, admission_control& admission, connection_reaper& reaper,
+                      shared::network::ip_ban_list& ip_bans)
           : service{keycap::root::network::service_mode::Server, shared::network::logon_service_type, thread_count}
-          , locator_{locator}
+          , account_services_{account_services}
           , realm_manager_{realm_manager}
+          , admission_{admission}
+          , reaper_{reaper}
+          , ip_bans_{ip_bans}
         {
         }
 
         virtual bool on_new_connection(SharedHandler handler) override;
 
+        // Returns nullptr for a banned address, which on_new_connection then rejects
         virtual SharedHandler make_handler(boost::asio::ip::tcp::socket socket) override;
 
       private:
-        keycap::root::network::service_locator& locator_;
+        shared::network::account_service_ring& account_services_;
         realm_manager& realm_manager_;
+        admission_control& admission_;
+        connection_reaper& reaper_;
+        shared::network::ip_ban_list& ip_bans_;
     };
 }
\ No newline at end of file
@@ -97,14 +97,31 @@ namespace keycap::logonserver
     {
         auto command = stream.peek<keycap::protocol::shared_command>();
 
-        if (command != keycap::protocol::shared_command::realm_hello)
-            return shared::network::state_result::abort;
+        switch (command)
+        {
+            case keycap::protocol::shared_command::realm_hello:
+            {
+                auto packet = keycap::protocol::realm_hello::decode(stream);
 
-        auto packet = keycap::protocol::realm_hello::decode(stream);
+                connection.realm_id_ = packet.info.id;
 
-        connection.realm_id_ = packet.info.id;
+                connection.realm_manager_.insert(packet.info);
+            }
+            break;
+            case keycap::protocol::shared_command::realm_status:
+            {
+                auto packet = keycap::protocol::realm_status::decode(stream);
 
-        connection.realm_manager_.insert(packet.info);
+                // A realm may only report its own load
+                if (packet.realm_id != connection.realm_id_)
+                    return shared::network::state_result::abort;
+
+                connection.realm_manager_.update_status(packet);
+            }
+            break;
+            default:
+                return shared::network::state_result::abort;
+        }
 
         return shared::network::state_result::ok;
     }
@@ -0,0 +1,76 @@
+/*
+    Copyright 2018-2019 KeycapEmu
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "streamable_file.hpp"
+
+#include <keycap/root/utility/utility.hpp>
+
+#include <botan/md5.h>
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <mutex>
+#include <unordered_map>
+
+namespace keycap::logonserver
+{
+    streamable_file::streamable_file(std::string const& path)
+      : file_{path.c_str(), boost::interprocess::read_only}
+      , region_{file_, boost::interprocess::read_only}
+      , size_{region_.get_size()}
+    {
+        Botan::MD5 md5;
+        md5.update(static_cast<uint8 const*>(region_.get_address()), region_.get_size());
+        auto digest = md5.final();
+        std::copy(digest.begin(), digest.end(), md5_.begin());
+    }
+
+    gsl::span<uint8 const> streamable_file::chunk(uint64 offset, size_t max_size) const
+    {
+        if (offset >= size_)
+            return {};
+
+        auto size = static_cast<size_t>(std::min<uint64>(size_ - offset, max_size));
+        return {static_cast<uint8 const*>(region_.get_address()) + offset, static_cast<std::ptrdiff_t>(size)};
+    }
+
+    std::shared_ptr<streamable_file const> get_streamable_file(std::string const& path)
+    {
+        static std::mutex mutex;
+        static std::unordered_map<std::string, std::shared_ptr<streamable_file const>> files;
+
+        std::lock_guard<std::mutex> lock{mutex};
+
+        if (auto file = files.find(path); file != files.end())
+            return file->second;
+
+        try
+        {
+            auto file = std::make_shared<streamable_file const>(path);
+            files[path] = file;
+            return file;
+        }
+        catch (std::exception const& e)
+        {
+            auto logger = keycap::root::utility::get_safe_logger("connections");
+            logger->error("[streamable_file] Unable to map {}: {}", path, e.what());
+
+            files[path] = nullptr;
+            return nullptr;
+        }
+    }
+}
@@ -0,0 +1,65 @@
+/*
+    Copyright 2018-2019 KeycapEmu
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#pragma once
+
+#include <keycap/root/types.hpp>
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <gsl/span>
+
+#include <array>
+#include <memory>
+#include <string>
+
+namespace keycap::logonserver
+{
+    // A read-only file (patch, survey, etc.) that is memory-mapped once and shared by all connections transferring it
+    class streamable_file
+    {
+      public:
+        // Maps the file at the given path. Throws boost::interprocess::interprocess_exception on failure
+        explicit streamable_file(std::string const& path);
+
+        streamable_file(streamable_file const&) = delete;
+        streamable_file& operator=(streamable_file const&) = delete;
+
+        uint64 size() const
+        {
+            return size_;
+        }
+
+        std::array<uint8, 16> const& md5() const
+        {
+            return md5_;
+        }
+
+        // Returns a view of at most `max_size` bytes starting at the given offset
+        gsl::span<uint8 const> chunk(uint64 offset, size_t max_size) const;
+
+      private:
+        boost::interprocess::file_mapping file_;
+        boost::interprocess::mapped_region region_;
+        uint64 size_ = 0;
+        std::array<uint8, 16> md5_{};
+    };
+
+    // Returns the process-wide instance of the file at the given path or nullptr if it can't be mapped.
+    // Files are mapped and hashed on first use and stay cached (as do failures) for the lifetime of the process
+    std::shared_ptr<streamable_file const> get_streamable_file(std::string const& path);
+}
@@ -0,0 +1,134 @@
+/*
+    Copyright 2018-2019 KeycapEmu
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#pragma once
+
+#include <keycap/root/types.hpp>
+
+#include <array>
+#include <vector>
+
+namespace keycap::logonserver
+{
+    // A hierarchical timer wheel. Scheduling and expiring are O(1); timers that are further away are kept on coarser
+    // levels and cascade down into finer ones as time passes.
+    // Time is measured in ticks; the wheel doesn't know how long a tick is. Not thread safe
+    template <typename T>
+    class timer_wheel
+    {
+        static constexpr uint64 slot_bits = 6;
+        static constexpr uint64 slot_count = 1 << slot_bits;
+        static constexpr uint64 slot_mask = slot_count - 1;
+        static constexpr size_t level_count = 4;
+
+        // Everything further away is clamped to the last slot of the highest level
+        static constexpr uint64 max_delta = (uint64{1} << (slot_bits * level_count)) - 1;
+
+        struct entry
+        {
+            uint64 expires;
+            T value;
+        };
+
+      public:
+        explicit timer_wheel(uint64 current_tick = 0)
+          : current_tick_{current_tick}
+        {
+        }
+
+        // Schedules the given value to expire once the given tick has been reached
+        void schedule(uint64 expires, T value)
+        {
+            insert(entry{expires, std::move(value)});
+            ++size_;
+        }
+
+        // Advances the wheel up to and including the given tick and calls `on_expired(T&)` for every value that has
+        // expired on the way
+        template <typename FUNC>
+        void advance(uint64 tick, FUNC&& on_expired)
+        {
+            while (current_tick_ <= tick)
+            {
+                auto index = current_tick_ & slot_mask;
+
+                // Every time the finest level wraps around the next slot of the level above is due
+                for (size_t level = 1; level < level_count && index == 0; ++level)
+                {
+                    index = (current_tick_ >> (slot_bits * level)) & slot_mask;
+                    cascade(level, index);
+                }
+
+                auto expired = std::move(levels_[0][current_tick_ & slot_mask]);
+                levels_[0][current_tick_ & slot_mask].clear();
+                ++current_tick_;
+
+                size_ -= expired.size();
+                for (auto& entry : expired)
+                    on_expired(entry.value);
+            }
+        }
+
+        // Returns the next tick that hasn't been processed yet
+        uint64 current_tick() const
+        {
+            return current_tick_;
+        }
+
+        // Returns the number of scheduled values
+        size_t size() const
+        {
+            return size_;
+        }
+
+      private:
+        void insert(entry entry)
+        {
+            // Timers that are already due expire with the current tick
+            if (entry.expires < current_tick_)
+                entry.expires = current_tick_;
+
+            auto delta = entry.expires - current_tick_;
+            if (delta > max_delta)
+            {
+                delta = max_delta;
+                entry.expires = current_tick_ + max_delta;
+            }
+
+            size_t level = 0;
+            while (level + 1 < level_count && delta >= (uint64{1} << (slot_bits * (level + 1))))
+                ++level;
+
+            auto index = (entry.expires >> (slot_bits * level)) & slot_mask;
+            levels_[level][index].push_back(std::move(entry));
+        }
+
+        // Moves all timers of the given slot one level (or more) down
+        void cascade(size_t level, uint64 index)
+        {
+            auto entries = std::move(levels_[level][index]);
+            levels_[level][index].clear();
+
+            for (auto& entry : entries)
+                insert(std::move(entry));
+        }
+
+        uint64 current_tick_;
+        size_t size_ = 0;
+
+        std::array<std::array<std::vector<entry>, slot_count>, level_count> levels_;
+    };
+}
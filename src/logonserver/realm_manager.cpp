@@ -16,28 +16,192 @@
 
 #include "realm_manager.hpp"
 
+#include <keycap/root/utility/utility.hpp>
+
+#include <spdlog/spdlog.h>
+
+#include <set>
+
 namespace keycap::logonserver
 {
+    // Population levels as understood by the client
+    constexpr float population_low = 0.5f;
+    constexpr float population_medium = 1.0f;
+    constexpr float population_high = 2.0f;
+
+    // Share of the realm's capacity (including the login queue) above which its population is medium or high
+    constexpr double medium_load = 0.4;
+    constexpr double high_load = 0.75;
+
+    // A realm whose timers fire this late (in microseconds) is treated as highly populated no matter its player count
+    constexpr uint32 overloaded_lag = 250'000;
+
+    realm_manager::realm_manager()
+    {
+        std::lock_guard<std::mutex> lock{mutex_};
+        rebuild();
+    }
+
     void realm_manager::insert(keycap::protocol::realm_info const& realm_data)
     {
+        std::lock_guard<std::mutex> lock{mutex_};
+
         if (auto const& realm = realms_.find(realm_data.id); realm != realms_.end())
             realm->second.realm_flags.clear_flag(keycap::protocol::realm_flag::offline);
         else
             realms_[realm_data.id] = realm_data;
+
+        rebuild();
     }
 
     void realm_manager::remove(keycap::protocol::realm_info const& realm_data)
     {
-        realms_.erase(realm_data.id);
+        remove(realm_data.id);
     }
 
     void realm_manager::set_offline(uint8_t id)
     {
-        realms_[id].realm_flags.set_flag(keycap::protocol::realm_flag::offline);
+        std::lock_guard<std::mutex> lock{mutex_};
+
+        auto realm = realms_.find(id);
+        if (realm == realms_.end() || realm->second.realm_flags.test_flag(keycap::protocol::realm_flag::offline))
+            return;
+
+        realm->second.realm_flags.set_flag(keycap::protocol::realm_flag::offline);
+        rebuild();
     }
 
     void realm_manager::remove(uint8_t id)
     {
-        realms_.erase(id);
+        std::lock_guard<std::mutex> lock{mutex_};
+
+        if (realms_.erase(id))
+            rebuild();
+    }
+
+    void realm_manager::update_status(keycap::protocol::realm_status const& status)
+    {
+        using keycap::protocol::realm_flag;
+
+        double load = 0.0;
+        if (status.capacity != 0)
+            load = static_cast<double>(status.online + status.queued) / status.capacity;
+
+        bool const full = status.capacity != 0 && status.online >= status.capacity;
+        bool const overloaded = status.lag >= overloaded_lag;
+
+        float population = population_low;
+        if (full || overloaded || load >= high_load)
+            population = population_high;
+        else if (load >= medium_load)
+            population = population_medium;
+
+        bool const recommended = population == population_low;
+
+        std::lock_guard<std::mutex> lock{mutex_};
+
+        auto realm = realms_.find(status.realm_id);
+        if (realm == realms_.end())
+            return;
+
+        auto& info = realm->second;
+        if (info.population == population && info.realm_flags.test_flag(realm_flag::full) == full
+            && info.realm_flags.test_flag(realm_flag::recommended) == recommended)
+            return;
+
+        info.population = population;
+
+        if (full)
+            info.realm_flags.set_flag(realm_flag::full);
+        else
+            info.realm_flags.clear_flag(realm_flag::full);
+
+        if (recommended)
+            info.realm_flags.set_flag(realm_flag::recommended);
+        else
+            info.realm_flags.clear_flag(realm_flag::recommended);
+
+        rebuild();
+    }
+
+    realm_manager::realm_list_ptr realm_manager::realm_list(uint16 build) const
+    {
+        auto current = std::atomic_load(&snapshot_);
+
+        if (auto list = current->by_build.find(build); list != current->by_build.end())
+            return list->second;
+
+        return current->fallback;
+    }
+
+    void realm_manager::rebuild()
+    {
+        std::set<uint16> builds;
+        for (auto&& [id, realm] : realms_)
+        {
+            if (realm.allowed_build != 0)
+                builds.insert(realm.allowed_build);
+        }
+
+        auto next = std::make_shared<snapshot>();
+        next->fallback = encode(0);
+        for (auto build : builds)
+            next->by_build[build] = encode(build);
+
+        std::atomic_store(&snapshot_, std::shared_ptr<snapshot const>{std::move(next)});
+    }
+
+    realm_manager::realm_list_ptr realm_manager::encode(uint16 build) const
+    {
+        // cmd, size, alwaysZero and the number of realms
+        constexpr size_t header_size = sizeof(uint8) + sizeof(uint16) + sizeof(uint32) + sizeof(uint16);
+        // type, locked and realm_flags
+        constexpr size_t leading_size = sizeof(uint8) + sizeof(uint8) + sizeof(uint8);
+        // num_characters, category and id
+        constexpr size_t trailing_size = sizeof(uint8) + sizeof(uint8) + sizeof(uint8);
+
+        protocol::server_realm_list outPacket;
+        std::vector<std::pair<uint8, size_t>> character_offsets;
+
+        // Every num_characters field is located while the realm is added, so the connections can patch in their
+        // character counts without encoding anything
+        size_t position = header_size;
+        for (auto&& [id, realm_data] : realms_)
+        {
+            auto& data = outPacket.data.emplace_back(protocol::realm_list_data{});
+            data.type = realm_data.type;
+            data.locked = realm_data.locked;
+            data.realm_flags = realm_data.realm_flags;
+            data.name = realm_data.name;
+            data.ip = realm_data.ip;
+            data.population = realm_data.population;
+            data.num_characters = 0;
+            data.category = realm_data.category;
+            data.id = realm_data.id;
+
+            if (realm_data.allowed_build != 0 && realm_data.allowed_build != build)
+                data.realm_flags.set_flag(protocol::realm_flag::offline);
+
+            // Both strings are zero terminated
+            position += leading_size + data.name.size() + 1 + data.ip.size() + 1 + sizeof(float);
+            character_offsets.emplace_back(data.id, position);
+            position += trailing_size;
+        }
+
+        outPacket.unk = 0xC01A;
+
+        auto list = std::make_shared<encoded_realm_list>();
+        list->packet = outPacket.encode();
+
+        // Patching at the wrong offsets would corrupt the list, so it's rather sent without any character counts
+        if (position + sizeof(uint16) == list->packet.size())
+            list->character_offsets = std::move(character_offsets);
+        else
+        {
+            auto logger = keycap::root::utility::get_safe_logger("console");
+            logger->error("[realm_manager] Unexpected realm list layout, character counts won't be sent");
+        }
+
+        return list;
     }
 }
\ No newline at end of file
@@ -18,14 +18,33 @@
 
 #include <generated/shared_protocol.hpp>
 
+#include <keycap/root/network/memory_stream.hpp>
+
+#include <memory>
+#include <mutex>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 namespace keycap::logonserver
 {
-    // Stores all realms that have made themselves known to us
+    // Stores all realms that have made themselves known to us.
+    // Readers never touch the realms themselves but an immutable snapshot of the already encoded realm lists which is
+    // rebuilt and swapped whenever a realm changes.
     class realm_manager
     {
       public:
+        struct encoded_realm_list
+        {
+            keycap::root::network::memory_stream packet;
+            // (realm id, offset of the realm's num_characters field within packet)
+            std::vector<std::pair<uint8, size_t>> character_offsets;
+        };
+
+        using realm_list_ptr = std::shared_ptr<encoded_realm_list const>;
+
+        realm_manager();
+
         // Inserts the given realm_data to the realm_manager.
         // Will set the realm to online if it has been added before.
         void insert(keycap::protocol::realm_info const& realm_data);
@@ -39,16 +58,32 @@ namespace keycap::logonserver
         // Removes a realm with the given id if it has been added
         void remove(uint8_t id);
 
-        // Iterates all stored realms. Requires callback with signature
-        // `void(keycap::shared::network::realm_info const& realm_data)`
-        template <typename FUN>
-        void iterate(FUN&& callback) const
-        {
-            for (auto&& [id, realm] : realms_)
-                callback(realm);
-        }
+        // Derives the realm's population and its recommended and full flags from the given load. The realm lists are
+        // only rebuilt if any of them changes
+        void update_status(keycap::protocol::realm_status const& status);
+
+        // Returns the encoded server_realm_list for clients of the given build.
+        // Realms that only allow a different build are flagged as offline
+        realm_list_ptr realm_list(uint16 build) const;
 
       private:
+        struct snapshot
+        {
+            // Realm lists for every build some realm is restricted to
+            std::unordered_map<uint16, realm_list_ptr> by_build;
+            // Realm list for all other builds
+            realm_list_ptr fallback;
+        };
+
+        // Rebuilds and publishes the snapshot. Requires mutex_ to be held
+        void rebuild();
+
+        realm_list_ptr encode(uint16 build) const;
+
+        std::mutex mutex_;
         std::unordered_map<uint8_t, keycap::protocol::realm_info> realms_;
+
+        // Only ever accessed through std::atomic_load/std::atomic_store
+        std::shared_ptr<snapshot const> snapshot_;
     };
 }
\ No newline at end of file
@@ -0,0 +1,77 @@
+/*
+    Copyright 2018-2019 KeycapEmu
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <cli/command.hpp>
+#include <generated/permissions.hpp>
+#include <network/account_service_ring.hpp>
+#include <rbac/role.hpp>
+
+#include <iostream>
+
+namespace rbac = keycap::shared::rbac;
+
+extern keycap::shared::network::account_service_ring& get_account_services();
+
+namespace keycap::realmserver::cli
+{
+    bool list_command(std::vector<std::string> const& args, rbac::role const& role)
+    {
+        for (auto const& endpoint : get_account_services().endpoints())
+            std::cout << endpoint << '\n';
+
+        return true;
+    }
+
+    bool join_command(std::vector<std::string> const& args, rbac::role const& role)
+    {
+        if (args.empty())
+            return false;
+
+        if (!get_account_services().join(args[0]))
+            std::cout << "Unable to join " << args[0] << ". It's either invalid or has already joined\n";
+
+        return true;
+    }
+
+    bool leave_command(std::vector<std::string> const& args, rbac::role const& role)
+    {
+        if (args.empty())
+            return false;
+
+        if (!get_account_services().leave(args[0]))
+            std::cout << args[0] << " hasn't joined\n";
+
+        return true;
+    }
+
+    keycap::shared::cli::command register_account_services()
+    {
+        using keycap::shared::permission;
+        using namespace std::string_literals;
+
+        std::vector<keycap::shared::cli::command> commands = {
+            keycap::shared::cli::command{"list", permission::CommandAccountServices, list_command,
+                                         "Lists all accountservers account lookups are spread over"s},
+            keycap::shared::cli::command{"join", permission::CommandAccountServices, join_command,
+                                         "Adds an accountserver. Arguments: host:port"s},
+            keycap::shared::cli::command{"leave", permission::CommandAccountServices, leave_command,
+                                         "Removes an accountserver. Arguments: host:port"s},
+        };
+
+        return keycap::shared::cli::command{"accountservers"s, permission::CommandAccountServices, nullptr,
+                                            "Accountserver ring specific commands"s, commands};
+    }
+}
\ No newline at end of file
@@ -0,0 +1,51 @@
+/*
+    Copyright 2018-2019 KeycapEmu
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <cli/command.hpp>
+#include <cryptography/crypto_executor.hpp>
+#include <generated/permissions.hpp>
+#include <rbac/role.hpp>
+
+#include <spdlog/fmt/fmt.h>
+
+#include <iostream>
+
+namespace rbac = keycap::shared::rbac;
+
+extern keycap::shared::cryptography::crypto_executor& get_crypto_executor();
+
+namespace keycap::realmserver::cli
+{
+    bool crypto_command(std::vector<std::string> const& args, rbac::role const& role)
+    {
+        auto& executor = get_crypto_executor();
+
+        std::cout << fmt::format("Crypto threads: {} queued: {}/{} active: {} completed: {} rejected: {}\n",
+                                 executor.thread_count(), executor.queue_depth(), executor.queue_size(),
+                                 executor.active(), executor.completed(), executor.rejected());
+
+        return true;
+    }
+
+    keycap::shared::cli::command register_crypto()
+    {
+        using keycap::shared::permission;
+        using namespace std::string_literals;
+
+        return keycap::shared::cli::command{"crypto"s, permission::CommandCrypto, &crypto_command,
+                                            "Displays the crypto worker pool's queue depth and counters"s};
+    }
+}
@@ -0,0 +1,42 @@
+/*
+    Copyright 2018-2019 KeycapEmu
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#pragma once
+
+#include <cli/command.hpp>
+
+namespace keycap::realmserver::cli
+{
+    namespace cli = keycap::shared::cli;
+    extern cli::command register_account_services();
+    extern cli::command register_crypto();
+    extern cli::command register_ip_bans();
+
+    namespace impl
+    {
+        void register_command(cli::command const& command, cli::command_map& command_map)
+        {
+            command_map[command.name] = command;
+        }
+    }
+
+    void register_commands(cli::command_map& command_map)
+    {
+        impl::register_command(register_account_services(), command_map);
+        impl::register_command(register_crypto(), command_map);
+        impl::register_command(register_ip_bans(), command_map);
+    }
+}
@@ -21,6 +21,7 @@
 
 #include <generated/shared_protocol.hpp>
 
+#include <network/account_service_ring.hpp>
 #include <network/services.hpp>
 
 #include <keycap/root/network/service_locator.hpp>
@@ -36,15 +37,17 @@ extern uint8 get_realm_id();
 
 namespace keycap::realmserver
 {
-    character_handler::character_handler(player_session& session, keycap::root::network::service_locator& locator)
+    character_handler::character_handler(player_session& session,
+                                         shared::network::account_service_ring& account_services)
       : session_{session}
-      , locator_{locator}
+      , account_services_{account_services}
     {
         auto& handlers = get_handlers();
 
         keycap_add_handler(keycap::protocol::client_command::char_enum, this, &character_handler::handle_char_enum);
         keycap_add_handler(keycap::protocol::client_command::realm_split, this, &character_handler::handle_realm_split);
         keycap_add_handler(keycap::protocol::client_command::char_create, this, &character_handler::handle_char_create);
+        keycap_add_handler(keycap::protocol::client_command::char_delete, this, &character_handler::handle_char_delete);
     }
 
     bool character_handler::handle_char_create(keycap::protocol::client_char_create packet)
@@ -94,7 +97,8 @@ namespace keycap::realmserver
             return true;
         };
 
-        locator_.send_registered(shared_net::account_service_type, request.encode(), get_net_service(), on_reply);
+        if (auto locator = account_services_.by_id(session_.account_id()))
+            locator->send_registered(shared_net::account_service_type, request.encode(), get_net_service(), on_reply);
 
         /*
         static uint8 result = 47;
@@ -115,6 +119,33 @@ namespace keycap::realmserver
         return false;
     }
 
+    bool character_handler::handle_char_delete(keycap::protocol::client_char_delete packet)
+    {
+        keycap::protocol::char_delete request;
+        request.realm_id = get_realm_id();
+        request.account_id = session_.account_id();
+        request.character_id = static_cast<uint32>(packet.guid);
+
+        auto on_reply = [session = &session_](net::service_type sender, net::memory_stream data) {
+            if (data.peek<keycap::protocol::shared_command>() != keycap::protocol::shared_command::reply_char_delete)
+                return false;
+
+            auto reply = keycap::protocol::reply_char_delete::decode(data);
+
+            keycap::protocol::server_char_delete answer;
+            answer.result = reply.result;
+
+            session->send(answer.encode());
+
+            return true;
+        };
+
+        if (auto locator = account_services_.by_id(session_.account_id()))
+            locator->send_registered(shared_net::account_service_type, request.encode(), get_net_service(), on_reply);
+
+        return true;
+    }
+
     bool character_handler::handle_char_enum(keycap::protocol::client_char_enum packet)
     {
         auto logger = keycap::root::utility::get_safe_logger("connections");
@@ -141,7 +172,8 @@ namespace keycap::realmserver
             return true;
         };
 
-        locator_.send_registered(shared_net::account_service_type, request.encode(), get_net_service(), on_reply);
+        if (auto locator = account_services_.by_id(session_.account_id()))
+            locator->send_registered(shared_net::account_service_type, request.encode(), get_net_service(), on_reply);
 
         return true;
     }
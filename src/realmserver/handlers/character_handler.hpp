@@ -19,9 +19,9 @@
 #include <generated/character_select.hpp>
 #include <generated/realm_protocol.hpp>
 
-namespace keycap::root::network
+namespace keycap::shared::network
 {
-    class service_locator;
+    class account_service_ring;
 }
 
 namespace keycap::realmserver
@@ -31,9 +31,10 @@ namespace keycap::realmserver
     class character_handler
     {
       public:
-        explicit character_handler(player_session& session, keycap::root::network::service_locator& locator);
+        explicit character_handler(player_session& session, shared::network::account_service_ring& account_services);
 
         bool handle_char_create(keycap::protocol::client_char_create packet);
+        bool handle_char_delete(keycap::protocol::client_char_delete packet);
         bool handle_char_enum(keycap::protocol::client_char_enum packet);
 
         bool handle_realm_split(keycap::protocol::client_realm_split pakcet);
@@ -41,6 +42,6 @@ namespace keycap::realmserver
       private:
         player_session& session_;
 
-        keycap::root::network::service_locator& locator_;
+        shared::network::account_service_ring& account_services_;
     };
 }
\ No newline at end of file
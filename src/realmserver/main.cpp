@@ -14,15 +14,21 @@
     limitations under the License.
 */
 
+#include "cli/registrar.hpp"
 #include "network/client_connection.hpp"
 #include "network/client_service.hpp"
+#include "realm_load.hpp"
 
 #include <generated/shared_protocol.hpp>
 
 #include <cli/helpers.hpp>
 #include <crash_dump.hpp>
+#include <cryptography/crypto_executor.hpp>
 #include <database/database.hpp>
 #include <logging/utility.hpp>
+#include <network/account_service_ring.hpp>
+#include <network/ip_ban_list.hpp>
+#include <network/reuseport_acceptor.hpp>
 #include <network/services.hpp>
 #include <rbac/rbac.hpp>
 #include <version.hpp>
@@ -33,12 +39,19 @@
 #include <keycap/root/utility/scope_exit.hpp>
 #include <keycap/root/utility/utility.hpp>
 
+#include <boost/asio/deadline_timer.hpp>
+
+#include <spdlog/fmt/fmt.h>
 #include <spdlog/spdlog.h>
 
 #include <botan/bigint.h>
 #include <cryptography/packet_scrambler.hpp>
 #include <keycap/root/network/srp6/utility.hpp>
 
+#include <algorithm>
+#include <limits>
+#include <mutex>
+
 namespace logging = keycap::shared::logging;
 namespace net = keycap::root::network;
 namespace shared_net = keycap::shared::network;
@@ -52,12 +65,14 @@ struct config
         std::string bind_ip;
         int16_t port;
         int threads;
+        // Gives every thread its own SO_REUSEPORT listener
+        bool reuse_port;
     } network;
 
     struct
     {
-        std::string host;
-        int16_t port;
+        // "host:port" of every accountserver. The first one is asked for the realm's data
+        std::vector<std::string> hosts;
     } account_service;
 
     struct
@@ -69,7 +84,17 @@ struct config
     struct
     {
         uint32 id;
+        // Number of players the realm is meant to hold. 0 if unlimited
+        uint32 capacity;
+        // Seconds between two realm_status updates. 0 disables them
+        int status_interval;
     } realm;
+
+    struct
+    {
+        int threads;
+        int queue_size;
+    } cryptography;
 };
 
 config parse_config(std::string config_file)
@@ -83,14 +108,24 @@ config parse_config(std::string config_file)
     cfg.network.bind_ip = cfg_file.get_or_default<std::string>("Network", "BindIp", "127.0.0.1");
     cfg.network.port = cfg_file.get_or_default<int16_t>("Network", "Port", 3724);
     cfg.network.threads = cfg_file.get_or_default<int>("Network", "Threads", 1);
+    cfg.network.reuse_port = cfg_file.get_or_default<bool>("Network", "ReusePort", false);
 
-    cfg.account_service.host = cfg_file.get_or_default<std::string>("AccountService", "Host", "127.0.0.1");
-    cfg.account_service.port = cfg_file.get_or_default<int16_t>("AccountService", "Port", 6660);
+    // Hosts takes precedence over the single Host and Port
+    auto account_host = cfg_file.get_or_default<std::string>("AccountService", "Host", "127.0.0.1");
+    auto account_port = cfg_file.get_or_default<int16_t>("AccountService", "Port", 6660);
+    auto account_hosts = cfg_file.get_or_default<std::string>("AccountService", "Hosts",
+                                                              fmt::format("{}:{}", account_host, account_port));
+    cfg.account_service.hosts = shared_net::parse_endpoints(account_hosts);
 
     cfg.logon_service.host = cfg_file.get_or_default<std::string>("LogonService", "Host", "127.0.0.1");
     cfg.logon_service.port = cfg_file.get_or_default<int16_t>("LogonService", "Port", 6662);
 
     cfg.realm.id = cfg_file.get_or_default<uint32>("Realm", "Id", 1);
+    cfg.realm.capacity = cfg_file.get_or_default<uint32>("Realm", "Capacity", 1000);
+    cfg.realm.status_interval = cfg_file.get_or_default<int>("Realm", "StatusInterval", 5);
+
+    cfg.cryptography.threads = cfg_file.get_or_default<int>("Cryptography", "Threads", 2);
+    cfg.cryptography.queue_size = cfg_file.get_or_default<int>("Cryptography", "QueueSize", 1024);
 
     return cfg;
 }
@@ -118,6 +153,44 @@ void kill_network_threads(std::vector<std::thread>& thread_pool)
     }
 }
 
+std::unique_ptr<keycap::shared::network::account_service_ring> account_services;
+
+keycap::shared::network::account_service_ring& get_account_services()
+{
+    return *account_services;
+}
+
+keycap::shared::network::ip_ban_list ip_bans;
+
+keycap::shared::network::ip_ban_list& get_ip_bans()
+{
+    return ip_bans;
+}
+
+// Reloads the ip bans from any known accountserver. Returns false if there is none
+bool reload_ip_bans()
+{
+    auto locator = get_account_services().any();
+    if (!locator)
+        return false;
+
+    keycap::shared::network::fetch_ip_bans(*locator, get_net_service(), ip_bans);
+    return true;
+}
+
+net::service_locator& get_logon_locator()
+{
+    static net::service_locator logon_locator;
+    return logon_locator;
+}
+
+std::unique_ptr<keycap::shared::cryptography::crypto_executor> crypto_executor;
+
+keycap::shared::cryptography::crypto_executor& get_crypto_executor()
+{
+    return *crypto_executor;
+}
+
 keycap::shared::cli::command_map commands;
 
 auto& get_command_map()
@@ -130,6 +203,39 @@ void register_command(keycap::shared::cli::command const& command)
     commands[command.name] = command;
 }
 
+keycap::realmserver::realm_load realm_load;
+
+keycap::realmserver::realm_load& get_realm_load()
+{
+    return realm_load;
+}
+
+// Sends the realm's load to the logonserver every StatusInterval seconds
+void schedule_realm_status(boost::asio::deadline_timer& timer, config const& config)
+{
+    auto expected = std::chrono::steady_clock::now() + std::chrono::seconds{config.realm.status_interval};
+
+    timer.expires_from_now(boost::posix_time::seconds{config.realm.status_interval});
+    timer.async_wait([&timer, &config, expected](boost::system::error_code const& error) {
+        if (error)
+            return;
+
+        // The timer fires late if the net threads are too busy to pick it up
+        auto lag = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - expected);
+
+        keycap::protocol::realm_status status;
+        status.realm_id = static_cast<uint8>(config.realm.id);
+        status.online = get_realm_load().online;
+        status.queued = get_realm_load().queued;
+        status.capacity = config.realm.capacity;
+        status.lag = static_cast<uint32>(std::clamp<int64_t>(lag.count(), 0, std::numeric_limits<uint32>::max()));
+
+        get_logon_locator().send_to(shared_net::logon_realm_service_type, status.encode());
+
+        schedule_realm_status(timer, config);
+    });
+}
+
 void get_realm_info(keycap::root::network::service_locator& locator, config& config)
 {
     keycap::protocol::request_realm_data packet;
@@ -137,7 +243,7 @@ void get_realm_info(keycap::root::network::service_locator& locator, config& con
 
     locator.send_registered(
         shared_net::account_service_type, packet.encode(), get_net_service(),
-        [&locator, &config](net::service_type sender, net::memory_stream data) {
+        [&config](net::service_type sender, net::memory_stream data) {
             if (data.peek<keycap::protocol::shared_command>() != keycap::protocol::shared_command::reply_realm_data)
                 return false;
 
@@ -162,15 +268,32 @@ void get_realm_info(keycap::root::network::service_locator& locator, config& con
 
                 console->info("Listening to {} on port {} with {} thread(s).", ip, port, config.network.threads);
 
-                static keycap::realmserver::client_service service{locator, config.network.threads};
-                if (!service.running())
+                static keycap::realmserver::client_service service{get_account_services(), ip_bans,
+                                                                   config.network.threads};
+                static shared_net::reuseport_server<keycap::realmserver::client_service> reuseport{service};
+                if (config.network.reuse_port && shared_net::reuseport_supported())
+                {
+                    if (!reuseport.running())
+                        reuseport.start(ip, static_cast<uint16>(port), config.network.threads);
+                }
+                else if (!service.running())
+                {
+                    if (config.network.reuse_port)
+                        console->warn("SO_REUSEPORT isn't supported. Falling back to a single acceptor");
+
                     service.start(ip, port);
+                }
+
+                static boost::asio::deadline_timer status_timer{get_net_service()};
+                static std::once_flag status_started;
+                if (config.realm.status_interval > 0)
+                    std::call_once(status_started, [&config] { schedule_realm_status(status_timer, config); });
             };
 
             net::service_locator::located_callback_container container{get_net_service(), callback};
 
-            locator.locate(shared_net::logon_realm_service_type, config.logon_service.host, config.logon_service.port,
-                           container);
+            get_logon_locator().locate(shared_net::logon_realm_service_type, config.logon_service.host,
+                                       config.logon_service.port, container);
 
             return true;
         });
@@ -202,6 +325,7 @@ int main()
                   keycap::emu::version::GIT_HASH);
 
     bool running = true;
+    keycap::realmserver::cli::register_commands(commands);
 
     using namespace std::string_literals;
     using keycap::shared::permission;
@@ -214,18 +338,33 @@ int main()
                              },
                              "Shuts down the Server"s});
 
+    crypto_executor = std::make_unique<keycap::shared::cryptography::crypto_executor>(config.cryptography.threads,
+                                                                                      config.cryptography.queue_size);
+
     boost::asio::io_service::work net_work{get_net_service()};
     std::vector<std::thread> net_thread_pool;
     init_network_threads(net_thread_pool, config);
     SCOPE_EXIT(sc2, [&] { kill_network_threads(net_thread_pool); });
 
+    // Stop the crypto threads before the network threads their results are posted to
+    QUICK_SCOPE_EXIT(sc3, [] { crypto_executor.reset(); });
+
     net::service_locator::located_callback_container container{
-        get_net_service(), [&](auto& locator, auto type) { get_realm_info(locator, config); }};
+        get_net_service(), [&](auto& locator, auto type) {
+            keycap::shared::network::fetch_ip_bans(locator, get_net_service(), ip_bans);
+            get_realm_info(locator, config);
+        }};
 
     console->info("Attempting to locate {}...", shared_net::account_service.to_string());
-    keycap::root::network::service_locator locator;
-    locator.locate(shared_net::account_service_type, config.account_service.host, config.account_service.port,
-                   container);
+    account_services = std::make_unique<keycap::shared::network::account_service_ring>();
+    for (size_t i = 0; i < config.account_service.hosts.size(); ++i)
+    {
+        auto const& endpoint = config.account_service.hosts[i];
+
+        bool joined = i == 0 ? account_services->join(endpoint, container) : account_services->join(endpoint);
+        if (!joined)
+            console->error("Invalid account service endpoint {}", endpoint);
+    }
 
     keycap::shared::cli::run_command_line(
         keycap::shared::rbac::role{0, "Console", keycap::shared::rbac::get_all_permissions()}, running);
@@ -18,6 +18,7 @@
 #include "player_session.hpp"
 
 #include <cryptography/packet_scrambler.hpp>
+#include <network/account_service_ring.hpp>
 #include <network/services.hpp>
 
 #include <keycap/root/utility/random.hpp>
@@ -36,10 +37,13 @@ constexpr size_t maximum_packet_size = 0x2800; // the client does not support la
 namespace keycap::realmserver
 {
     client_connection::client_connection(boost::asio::ip::tcp::socket socket, net::service_base& service,
-                                         net::service_locator& locator)
+                                         shared::network::account_service_ring& account_services,
+                                         std::string remote_address)
       : connection{std::move(socket), service}
       , auth_seed_{util::random_ui32()}
-      , locator_{locator}
+      , strand_{io_service_}
+      , account_services_{account_services}
+      , remote_address_{std::move(remote_address)}
       , login_queue_{io_service_, scrambler_}
     {
         router_.configure_inbound(this);
@@ -70,6 +74,18 @@ namespace keycap::realmserver
     }
 
     bool client_connection::on_data(net::data_router const& router, net::service_type service, gsl::span<uint8_t> data)
+    {
+        // The state is shared with the continuations of crypto jobs, so incoming data is handled within the strand, too
+        auto self = std::static_pointer_cast<client_connection>(shared_from_this());
+        io_service_.post(strand_.wrap([self, &router, data = std::vector<uint8_t>{data.begin(), data.end()}]() mutable {
+            if (!self->handle_data(router, data))
+                self->close();
+        }));
+
+        return true;
+    }
+
+    bool client_connection::handle_data(net::data_router const& router, gsl::span<uint8_t> data)
     {
         if (data.size() > maximum_packet_size)
             return false;
@@ -124,7 +140,8 @@ namespace keycap::realmserver
         else
         {
             logger->debug("[client_connection] Connection closed");
-            state_ = disconnected{};
+            auto self = std::static_pointer_cast<client_connection>(shared_from_this());
+            io_service_.post(strand_.wrap([self]() { self->state_ = disconnected{}; }));
         }
 
         return true;
@@ -135,14 +152,16 @@ namespace keycap::realmserver
         return auth_seed_;
     }
 
-    root::network::service_locator& client_connection::locator() const
+    shared::network::account_service_ring& client_connection::account_services() const
     {
-        return locator_;
+        return account_services_;
     }
 
-    void client_connection::query_account_service(keycap::root::network::memory_stream const& message,
+    void client_connection::query_account_service(std::string const& account_name,
+                                                  keycap::root::network::memory_stream const& message,
                                                   keycap::root::network::service_locator::registered_callback callback)
     {
-        locator().send_registered(shared_net::account_service_type, message, io_service_, callback);
+        if (auto locator = account_services_.by_name(account_name))
+            locator->send_registered(shared_net::account_service_type, message, io_service_, callback);
     }
 }
\ No newline at end of file
@@ -29,11 +29,12 @@
 #include <keycap/root/network/message_handler.hpp>
 #include <keycap/root/network/service_locator.hpp>
 
+#include <string>
 #include <variant>
 
-namespace keycap::root::network
+namespace keycap::shared::network
 {
-    class service_locator;
+    class account_service_ring;
 }
 
 namespace keycap::protocol
@@ -55,7 +56,7 @@ namespace keycap::realmserver
     {
       public:
         client_connection(boost::asio::ip::tcp::socket socket, keycap::root::network::service_base& service,
-                          keycap::root::network::service_locator& locator);
+                          shared::network::account_service_ring& account_services, std::string remote_address);
 
         bool on_data(keycap::root::network::data_router const& router, keycap::root::network::service_type service,
                      gsl::span<uint8_t> data) override;
@@ -65,13 +66,23 @@ namespace keycap::realmserver
 
         uint32_t auth_seed() const;
 
-        keycap::root::network::service_locator& locator() const;
+        shared::network::account_service_ring& account_services() const;
+
+        std::string const& remote_address() const
+        {
+            return remote_address_;
+        }
 
       private:
         using state_result = std::tuple<shared::network::state_result, uint16, keycap::protocol::client_command>;
 
         friend class player_session;
-        void query_account_service(keycap::root::network::memory_stream const& message,
+
+        // Feeds the given data to the current state. Returns false if the connection has to be closed. Runs on strand_
+        bool handle_data(keycap::root::network::data_router const& router, gsl::span<uint8_t> data);
+
+        // Sends the given message to the account service responsible for the given account
+        void query_account_service(std::string const& account_name, keycap::root::network::memory_stream const& message,
                                    keycap::root::network::service_locator::registered_callback callback);
 
         struct validate_result
@@ -113,8 +124,9 @@ namespace keycap::realmserver
             void on_account_reply(std::weak_ptr<client_connection> connection,
                                   keycap::protocol::reply_session_key& reply, account_reply_data& data);
 
-            bool verify_digest(std::string const& account_name, uint32 client_seed, uint32 auth_seed,
-                               Botan::BigInt const& session_key, std::array<uint8, 20> const& client_digest);
+            // Runs on the crypto_executor
+            static bool verify_digest(std::string const& account_name, uint32 client_seed, uint32 auth_seed,
+                                      Botan::BigInt const& session_key, std::array<uint8, 20> const& client_digest);
 
             std::string name = "JustConnected";
         };
@@ -139,7 +151,11 @@ namespace keycap::realmserver
         uint32_t auth_seed_ = 0;
         keycap::root::network::memory_stream input_stream_;
 
-        keycap::root::network::service_locator& locator_;
+        // Incoming data and the continuations of crypto jobs are handled on this strand
+        boost::asio::io_service::strand strand_;
+
+        shared::network::account_service_ring& account_services_;
+        std::string remote_address_;
 
         shared::cryptography::packet_scrambler scrambler_;
         login_queue login_queue_;
@@ -17,15 +17,33 @@
 #include "client_service.hpp"
 #include "client_connection.hpp"
 
+#include <network/ip_ban_list.hpp>
+
+#include <keycap/root/utility/utility.hpp>
+
+#include <spdlog/spdlog.h>
+
 namespace keycap::realmserver
 {
     bool client_service::on_new_connection(SharedHandler handler)
     {
-        return true;
+        // make_handler didn't create a connection for a banned address
+        return handler != nullptr;
     }
 
     client_service::SharedHandler client_service::make_handler(boost::asio::ip::tcp::socket socket)
     {
-        return std::make_shared<client_connection>(std::move(socket), *this, locator_);
+        boost::system::error_code error;
+        auto address = socket.remote_endpoint(error).address();
+
+        // Banned networks don't get anything but a closed socket, so there's no need to construct a connection first
+        if (!error && ip_bans_.banned(address))
+        {
+            auto logger = keycap::root::utility::get_safe_logger("connections");
+            logger->debug("[client_service] Rejected connection from banned address {}", address.to_string());
+            return nullptr;
+        }
+
+        return std::make_shared<client_connection>(std::move(socket), *this, account_services_, address.to_string());
     }
 }
\ No newline at end of file
@@ -22,9 +22,10 @@
 
 #include <memory>
 
-namespace keycap::root::network
+namespace keycap::shared::network
 {
-    class service_locator;
+    class account_service_ring;
+    class ip_ban_list;
 }
 
 namespace keycap::realmserver
@@ -34,17 +35,21 @@ namespace keycap::realmserver
     class client_service : public keycap::root::network::service<client_connection>
     {
       public:
-        explicit client_service(root::network::service_locator& locator, int thread_count)
+        client_service(shared::network::account_service_ring& account_services, shared::network::ip_ban_list& ip_bans,
+                       int thread_count)
           : service{keycap::root::network::service_mode::Server, shared::network::realm_service_type, thread_count}
-          , locator_{locator}
+          , account_services_{account_services}
+          , ip_bans_{ip_bans}
         {
         }
 
         virtual bool on_new_connection(SharedHandler handler) override;
 
+        // Returns nullptr for a banned address, which on_new_connection then rejects
         virtual SharedHandler make_handler(boost::asio::ip::tcp::socket socket) override;
 
       private:
-        root::network::service_locator& locator_;
+        shared::network::account_service_ring& account_services_;
+        shared::network::ip_ban_list& ip_bans_;
     };
 }
\ No newline at end of file
@@ -70,7 +70,7 @@ namespace keycap::realmserver
             return std::make_tuple(result, size, opcode);
         }
 
-        character_handler ch{*connection.player_session_, connection.locator_};
+        character_handler ch{*connection.player_session_, connection.account_services_};
 
         try
         {
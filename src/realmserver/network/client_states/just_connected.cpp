@@ -16,11 +16,12 @@
 
 #include "../client_connection.hpp"
 
+#include <cryptography/crypto_executor.hpp>
+#include <cryptography/random.hpp>
 #include <generated/authentication.hpp>
 
 #include <keycap/root/network/srp6/utility.hpp>
 
-#include <botan/auto_rng.h>
 #include <botan/bigint.h>
 #include <botan/sha160.h>
 
@@ -29,6 +30,8 @@
 namespace net = keycap::root::network;
 namespace srp6 = keycap::root::network::srp6;
 
+extern keycap::shared::cryptography::crypto_executor& get_crypto_executor();
+
 constexpr size_t minimum_packet_size = sizeof(uint16) + sizeof(uint32); // size + opcode
 constexpr size_t maximum_packet_size = 0x2800; // the client does not support larger buffers so why should we? ;)
 
@@ -36,8 +39,8 @@ namespace keycap::realmserver
 {
     client_connection::just_connected::just_connected(client_connection& connection)
     {
-        auto seed2 = Botan::AutoSeeded_RNG().random_vec(16);
-        auto seed3 = Botan::AutoSeeded_RNG().random_vec(16);
+        auto seed2 = shared::cryptography::random_array<16>();
+        auto seed3 = shared::cryptography::random_array<16>();
 
         protocol::server_challange challange;
         challange.seed = connection.auth_seed();
@@ -72,7 +75,7 @@ namespace keycap::realmserver
             return true;
         };
 
-        connection.query_account_service(request.encode(), callback);
+        connection.query_account_service(request.account_name, request.encode(), callback);
 
         return std::make_tuple(result, size, opcode);
     }
@@ -97,20 +100,41 @@ namespace keycap::realmserver
             return;
         }
 
-        auto session_key = *reply.session_key;
-        Botan::BigInt K{session_key};
-        if (!verify_digest(data.account_name, data.client_seed, conn->auth_seed(), K, data.digest))
+        Botan::BigInt K{*reply.session_key};
+
+        auto job = [account_name = data.account_name, client_seed = data.client_seed, auth_seed = conn->auth_seed(), K,
+                    digest = data.digest] { return verify_digest(account_name, client_seed, auth_seed, K, digest); };
+
+        auto continuation = [connection, account_name = data.account_name, addon_data = data.addon_data,
+                             K](std::optional<bool> verified) mutable {
+            auto conn = connection.lock();
+            if (!conn || !std::holds_alternative<just_connected>(conn->state_))
+                return;
+
+            // A digest that couldn't be verified at all is treated like a wrong one
+            if (!verified.value_or(false))
+            {
+                protocol::server_auth_error session;
+                session.result = protocol::auth_result::unknown_account;
+                conn->send(session.encode());
+                // TODO: send error. See https://github.com/DennisWG/KeycapEmu/issues/11
+                auto logger = root::utility::get_safe_logger("connections");
+                logger->info("[client_connection::just_connected] User {} tried to log in with incorrect login info!",
+                             account_name);
+                return;
+            }
+
+            conn->state_ = authenticated{conn, account_name, protocol::client_addon_info::decode(addon_data), K};
+        };
+
+        if (!get_crypto_executor().post(conn, conn->strand_, std::move(job), std::move(continuation)))
         {
             protocol::server_auth_error session;
-            session.result = protocol::auth_result::unknown_account;
+            session.result = protocol::auth_result::db_busy;
             conn->send(session.encode());
-            // TODO: send error. See https://github.com/DennisWG/KeycapEmu/issues/11
-            logger->info("[client_connection::just_connected] User {} tried to log in with incorrect login info!",
+            logger->info("[client_connection::just_connected] Crypto queue is full! Rejecting login of user {}",
                          data.account_name);
-            return;
         }
-
-        conn->state_ = authenticated{conn, data.account_name, protocol::client_addon_info::decode(data.addon_data), K};
     }
 
     bool client_connection::just_connected::verify_digest(std::string const& account_name, uint32 client_seed,
@@ -15,12 +15,15 @@
 */
 
 #include "login_queue.hpp"
+#include "../realm_load.hpp"
 #include <generated/authentication.hpp>
 
 #include <cryptography/packet_scrambler.hpp>
 
 #include <keycap/root/network/connection.hpp>
 
+extern keycap::realmserver::realm_load& get_realm_load();
+
 namespace keycap::realmserver
 {
     login_queue::login_queue(boost::asio::io_service& io_service, shared::cryptography::packet_scrambler& scrambler)
@@ -30,6 +33,14 @@ namespace keycap::realmserver
     {
     }
 
+    login_queue::~login_queue()
+    {
+        get_realm_load().queued -= static_cast<uint32>(queue_.size());
+
+        if (logged_in_)
+            --get_realm_load().online;
+    }
+
     void login_queue::enqueue(std::weak_ptr<keycap::root::network::connection_base> connection)
     {
         if (connection.expired())
@@ -44,6 +55,7 @@ namespace keycap::realmserver
             return;
 
         queue_.push_back(connection);
+        ++get_realm_load().queued;
         auto position = static_cast<uint32>(queue_.size());
 
         keycap::protocol::server_auth_wait_queue packet;
@@ -67,6 +79,7 @@ namespace keycap::realmserver
 
         connection = queue_.front();
         queue_.pop_front();
+        --get_realm_load().queued;
 
         update_positions();
         if (connection.expired())
@@ -78,6 +91,9 @@ namespace keycap::realmserver
 
         connection.lock()->send(stream.to_span());
 
+        logged_in_ = true;
+        ++get_realm_load().online;
+
         if (!queue_.empty())
             io_service_.post(work_strand_.wrap([this]() { login_first_connection(); }));
     }
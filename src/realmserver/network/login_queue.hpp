@@ -40,6 +40,8 @@ namespace keycap::realmserver
       public:
         login_queue(boost::asio::io_service& io_service, shared::cryptography::packet_scrambler& scrambler);
 
+        ~login_queue();
+
         // Enqueues the given connection
         void enqueue(std::weak_ptr<keycap::root::network::connection_base> connection);
 
@@ -58,5 +60,8 @@ namespace keycap::realmserver
         std::deque<std::weak_ptr<keycap::root::network::connection_base>> queue_;
 
         shared::cryptography::packet_scrambler& scrambler_;
+
+        // Set once the connection has left the queue and is counted as online
+        bool logged_in_ = false;
     };
 }
\ No newline at end of file
@@ -49,7 +49,7 @@ namespace keycap::realmserver
             return true;
         };
 
-        connection.query_account_service(request.encode(), callback);
+        connection.query_account_service(account_name, request.encode(), callback);
     }
 
     void player_session::send(keycap::root::network::memory_stream&& stream)
@@ -0,0 +1,116 @@
+/*
+    Copyright 2018-2019 KeycapEmu
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "crypto_executor.hpp"
+
+#include <keycap/root/utility/utility.hpp>
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+
+namespace keycap::shared::cryptography
+{
+    crypto_executor::crypto_executor(int thread_count, size_t queue_size)
+      : queue_size_{std::max<size_t>(queue_size, 1)}
+    {
+        for (int i = 0; i < std::max(thread_count, 1); ++i)
+            threads_.emplace_back([this] { run(); });
+    }
+
+    crypto_executor::~crypto_executor()
+    {
+        {
+            std::lock_guard<std::mutex> lock{mutex_};
+            running_ = false;
+        }
+        condition_.notify_all();
+
+        for (auto& thread : threads_)
+            thread.join();
+    }
+
+    size_t crypto_executor::queue_depth() const
+    {
+        std::lock_guard<std::mutex> lock{mutex_};
+        return jobs_.size();
+    }
+
+    bool crypto_executor::enqueue(std::function<void()> job)
+    {
+        {
+            std::lock_guard<std::mutex> lock{mutex_};
+            if (jobs_.size() >= queue_size_)
+            {
+                ++rejected_;
+                return false;
+            }
+
+            jobs_.emplace_back(std::move(job));
+        }
+
+        condition_.notify_one();
+        return true;
+    }
+
+    void crypto_executor::log_failure(std::exception_ptr exception)
+    {
+        auto logger = keycap::root::utility::get_safe_logger("console");
+        try
+        {
+            std::rethrow_exception(exception);
+        }
+        catch (std::exception const& e)
+        {
+            logger->error("[crypto_executor] {}", e.what());
+        }
+        catch (...)
+        {
+            logger->error("[crypto_executor] Job failed with an unknown exception");
+        }
+    }
+
+    void crypto_executor::run()
+    {
+        while (true)
+        {
+            std::function<void()> job;
+            {
+                std::unique_lock<std::mutex> lock{mutex_};
+                condition_.wait(lock, [this] { return !running_ || !jobs_.empty(); });
+
+                if (!running_)
+                    return;
+
+                job = std::move(jobs_.front());
+                jobs_.pop_front();
+            }
+
+            ++active_;
+            try
+            {
+                job();
+            }
+            catch (std::exception const& e)
+            {
+                auto logger = keycap::root::utility::get_safe_logger("console");
+                logger->error("[crypto_executor] {}", e.what());
+            }
+            --active_;
+            ++completed_;
+        }
+    }
+}
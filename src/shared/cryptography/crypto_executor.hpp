@@ -0,0 +1,145 @@
+/*
+    Copyright 2018-2019 KeycapEmu
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#pragma once
+
+#include <boost/asio.hpp>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace keycap::shared::cryptography
+{
+    // Runs CPU heavy cryptographic jobs (bignum math, digests) on its own threads so they don't stall the network
+    // threads. The queue is bounded; once it's full new jobs are rejected and the caller has to shed load.
+    class crypto_executor
+    {
+      public:
+        crypto_executor(int thread_count, size_t queue_size);
+        ~crypto_executor();
+
+        crypto_executor(crypto_executor const&) = delete;
+        crypto_executor& operator=(crypto_executor const&) = delete;
+
+        // Runs the given job on one of the crypto threads and posts the given continuation with the job's result onto
+        // the given strand. The continuation receives an empty std::optional (or false for jobs without a result) if
+        // the job threw. owner has to keep the strand alive and is held until the continuation has run.
+        // Returns false if the queue is full and the job has been rejected
+        template <typename Job, typename Continuation>
+        bool post(std::shared_ptr<void> owner, boost::asio::io_service::strand& strand, Job&& job,
+                  Continuation&& continuation)
+        {
+            return enqueue([owner = std::move(owner), &strand, job = std::forward<Job>(job),
+                            continuation = std::forward<Continuation>(continuation)]() mutable {
+                using result_type = std::invoke_result_t<Job&>;
+
+                if constexpr (std::is_void_v<result_type>)
+                {
+                    bool succeeded = true;
+                    try
+                    {
+                        job();
+                    }
+                    catch (...)
+                    {
+                        log_failure(std::current_exception());
+                        succeeded = false;
+                    }
+
+                    strand.post([owner = std::move(owner), succeeded,
+                                 continuation = std::move(continuation)]() mutable { continuation(succeeded); });
+                }
+                else
+                {
+                    std::optional<result_type> result;
+                    try
+                    {
+                        result.emplace(job());
+                    }
+                    catch (...)
+                    {
+                        log_failure(std::current_exception());
+                    }
+
+                    strand.post([owner = std::move(owner), result = std::move(result),
+                                 continuation = std::move(continuation)]() mutable {
+                        continuation(std::move(result));
+                    });
+                }
+            });
+        }
+
+        // Returns the number of jobs waiting for a free crypto thread
+        size_t queue_depth() const;
+
+        size_t queue_size() const
+        {
+            return queue_size_;
+        }
+
+        int thread_count() const
+        {
+            return static_cast<int>(threads_.size());
+        }
+
+        // Returns the number of jobs currently being executed
+        uint64_t active() const
+        {
+            return active_;
+        }
+
+        // Returns the number of jobs that have been executed
+        uint64_t completed() const
+        {
+            return completed_;
+        }
+
+        // Returns the number of jobs that have been rejected because the queue was full
+        uint64_t rejected() const
+        {
+            return rejected_;
+        }
+
+      private:
+        bool enqueue(std::function<void()> job);
+
+        static void log_failure(std::exception_ptr exception);
+
+        void run();
+
+        size_t queue_size_;
+
+        mutable std::mutex mutex_;
+        std::condition_variable condition_;
+        std::deque<std::function<void()>> jobs_;
+        bool running_ = true;
+
+        std::atomic_uint64_t active_{0};
+        std::atomic_uint64_t completed_{0};
+        std::atomic_uint64_t rejected_{0};
+
+        std::vector<std::thread> threads_;
+    };
+}
@@ -0,0 +1,99 @@
+/*
+    Copyright 2018-2019 KeycapEmu
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "ephemeral_pool.hpp"
+#include "random.hpp"
+
+#include <botan/numthry.h>
+
+#include <algorithm>
+
+namespace keycap::shared::cryptography::srp6
+{
+    constexpr size_t ephemeral_bits = 32 * 8;
+
+    ephemeral_pool::ephemeral_pool(Botan::BigInt const& N, Botan::BigInt const& g, size_t capacity)
+      : N_{N}
+      , g_{g}
+      , capacity_{std::max<size_t>(capacity, 1)}
+      , thread_{[this] { fill(); }}
+    {
+    }
+
+    ephemeral_pool::~ephemeral_pool()
+    {
+        {
+            std::lock_guard<std::mutex> lock{mutex_};
+            running_ = false;
+        }
+        refill_.notify_one();
+        thread_.join();
+    }
+
+    ephemeral ephemeral_pool::take()
+    {
+        {
+            std::lock_guard<std::mutex> lock{mutex_};
+            if (!ephemerals_.empty())
+            {
+                auto ephemeral = std::move(ephemerals_.front());
+                ephemerals_.pop_front();
+
+                if (ephemerals_.size() < capacity_ / 2)
+                    refill_.notify_one();
+
+                return ephemeral;
+            }
+        }
+
+        ++misses_;
+        refill_.notify_one();
+        return generate();
+    }
+
+    size_t ephemeral_pool::size() const
+    {
+        std::lock_guard<std::mutex> lock{mutex_};
+        return ephemerals_.size();
+    }
+
+    ephemeral ephemeral_pool::generate() const
+    {
+        Botan::BigInt b{thread_rng(), ephemeral_bits};
+        auto g_b = Botan::power_mod(g_, b, N_);
+
+        return ephemeral{std::move(b), std::move(g_b)};
+    }
+
+    void ephemeral_pool::fill()
+    {
+        std::unique_lock<std::mutex> lock{mutex_};
+
+        while (running_)
+        {
+            refill_.wait(lock, [this] { return !running_ || ephemerals_.size() < capacity_; });
+
+            while (running_ && ephemerals_.size() < capacity_)
+            {
+                lock.unlock();
+                auto ephemeral = generate();
+                lock.lock();
+
+                ephemerals_.push_back(std::move(ephemeral));
+            }
+        }
+    }
+}
@@ -0,0 +1,72 @@
+/*
+    Copyright 2018-2019 KeycapEmu
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#pragma once
+
+#include "srp6.hpp"
+
+#include <botan/bigint.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+namespace keycap::shared::cryptography::srp6
+{
+    // Keeps a number of (b, g^b mod N) pairs ready so the expensive modular exponentiation of an SRP6 challenge doesn't
+    // have to be done on the network threads. The pool is refilled by its own background thread.
+    class ephemeral_pool
+    {
+      public:
+        ephemeral_pool(Botan::BigInt const& N, Botan::BigInt const& g, size_t capacity);
+        ~ephemeral_pool();
+
+        ephemeral_pool(ephemeral_pool const&) = delete;
+        ephemeral_pool& operator=(ephemeral_pool const&) = delete;
+
+        // Returns a precomputed ephemeral or computes one inline if the pool ran dry
+        ephemeral take();
+
+        // Returns the number of precomputed ephemerals that are currently available
+        size_t size() const;
+
+        // Returns the number of times take() had to compute an ephemeral inline
+        uint64_t misses() const
+        {
+            return misses_;
+        }
+
+      private:
+        ephemeral generate() const;
+
+        void fill();
+
+        Botan::BigInt N_;
+        Botan::BigInt g_;
+        size_t capacity_;
+
+        mutable std::mutex mutex_;
+        std::condition_variable refill_;
+        std::deque<ephemeral> ephemerals_;
+        bool running_ = true;
+
+        std::atomic_uint64_t misses_{0};
+
+        std::thread thread_;
+    };
+}
@@ -0,0 +1,105 @@
+/*
+    Copyright 2018-2019 KeycapEmu
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "random.hpp"
+
+#include <botan/hmac_drbg.h>
+#include <botan/mac.h>
+#include <botan/system_rng.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace keycap::shared::cryptography
+{
+    buffered_rng::buffered_rng(size_t reseed_interval)
+      : drbg_{std::make_unique<Botan::HMAC_DRBG>(Botan::MessageAuthenticationCode::create_or_throw("HMAC(SHA-256)"),
+                                                 Botan::system_rng(), reseed_interval)}
+      , block_(block_size)
+      , position_{block_size}
+    {
+        drbg_->reseed_from_rng(Botan::system_rng());
+    }
+
+    buffered_rng::~buffered_rng() = default;
+
+    void buffered_rng::randomize(uint8 output[], size_t length)
+    {
+        // Requests larger than a block bypass the buffer
+        if (length > block_size)
+            return drbg_->randomize(output, length);
+
+        while (length > 0)
+        {
+            if (position_ == block_size)
+                refill();
+
+            auto size = std::min(length, block_size - position_);
+            std::memcpy(output, block_.data() + position_, size);
+
+            // Never hand out the same bytes twice
+            std::memset(block_.data() + position_, 0, size);
+
+            position_ += size;
+            output += size;
+            length -= size;
+        }
+    }
+
+    void buffered_rng::add_entropy(uint8 const input[], size_t length)
+    {
+        drbg_->add_entropy(input, length);
+
+        // Bytes generated before the entropy was added shouldn't be handed out anymore
+        position_ = block_size;
+    }
+
+    std::string buffered_rng::name() const
+    {
+        return "Buffered(" + drbg_->name() + ")";
+    }
+
+    void buffered_rng::clear()
+    {
+        drbg_->clear();
+        Botan::zeroise(block_);
+        position_ = block_size;
+    }
+
+    bool buffered_rng::is_seeded() const
+    {
+        return drbg_->is_seeded();
+    }
+
+    void buffered_rng::refill()
+    {
+        drbg_->randomize(block_.data(), block_.size());
+        position_ = 0;
+    }
+
+    buffered_rng& thread_rng()
+    {
+        thread_local buffered_rng rng;
+        return rng;
+    }
+
+    Botan::secure_vector<uint8> random_bytes(size_t size)
+    {
+        Botan::secure_vector<uint8> result(size);
+        thread_rng().randomize(result.data(), result.size());
+        return result;
+    }
+}
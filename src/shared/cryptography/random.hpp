@@ -0,0 +1,84 @@
+/*
+    Copyright 2018-2019 KeycapEmu
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#pragma once
+
+#include <keycap/root/types.hpp>
+
+#include <botan/rng.h>
+#include <botan/secmem.h>
+
+#include <array>
+#include <memory>
+#include <string>
+
+namespace Botan
+{
+    class HMAC_DRBG;
+}
+
+namespace keycap::shared::cryptography
+{
+    // An HMAC_DRBG(SHA-256) that is seeded from the operating system and reseeds itself every `reseed_interval`
+    // generate calls. Random bytes are handed out of a buffered block so most requests are just a copy.
+    // Not thread safe, use thread_rng() to get the calling thread's instance
+    class buffered_rng : public Botan::RandomNumberGenerator
+    {
+      public:
+        static constexpr size_t block_size = 4096;
+
+        explicit buffered_rng(size_t reseed_interval = 1024);
+        ~buffered_rng() override;
+
+        void randomize(uint8 output[], size_t length) override;
+
+        bool accepts_input() const override
+        {
+            return true;
+        }
+
+        void add_entropy(uint8 const input[], size_t length) override;
+
+        std::string name() const override;
+
+        void clear() override;
+
+        bool is_seeded() const override;
+
+      private:
+        // Refills the block from the DRBG
+        void refill();
+
+        std::unique_ptr<Botan::HMAC_DRBG> drbg_;
+        Botan::secure_vector<uint8> block_;
+        size_t position_;
+    };
+
+    // Returns the calling thread's buffered_rng
+    buffered_rng& thread_rng();
+
+    // Returns `size` random bytes from the calling thread's buffered_rng
+    Botan::secure_vector<uint8> random_bytes(size_t size);
+
+    // Returns N random bytes from the calling thread's buffered_rng
+    template <size_t N>
+    std::array<uint8, N> random_array()
+    {
+        std::array<uint8, N> result;
+        thread_rng().randomize(result.data(), result.size());
+        return result;
+    }
+}
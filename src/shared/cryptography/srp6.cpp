@@ -0,0 +1,182 @@
+/*
+    Copyright 2018-2019 KeycapEmu
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "srp6.hpp"
+#include "../string_utility.hpp"
+
+#include <botan/numthry.h>
+#include <botan/sha160.h>
+
+#include <algorithm>
+#include <array>
+
+namespace keycap::shared::cryptography::srp6
+{
+    constexpr size_t key_size = 32;
+    constexpr size_t proof_size = 20;
+    constexpr size_t session_key_size = 40;
+
+    std::vector<uint8> to_little_endian(Botan::BigInt const& value, size_t size)
+    {
+        auto big_endian = Botan::BigInt::encode_1363(value, size);
+        return std::vector<uint8>{big_endian.rbegin(), big_endian.rend()};
+    }
+
+    Botan::BigInt from_little_endian(uint8 const* data, size_t size)
+    {
+        std::vector<uint8> big_endian{data, data + size};
+        std::reverse(big_endian.begin(), big_endian.end());
+        return Botan::BigInt::decode(big_endian);
+    }
+
+    Botan::BigInt scrambler(Botan::BigInt const& A, Botan::BigInt const& B)
+    {
+        Botan::SHA_1 sha;
+        sha.update(to_little_endian(A, key_size));
+        sha.update(to_little_endian(B, key_size));
+        auto hash = sha.final();
+
+        return from_little_endian(hash.data(), hash.size());
+    }
+
+    Botan::BigInt interleaved_session_key(Botan::BigInt const& S)
+    {
+        auto secret = to_little_endian(S, key_size);
+
+        std::array<uint8, key_size / 2> even{};
+        std::array<uint8, key_size / 2> odd{};
+        for (size_t i = 0; i < key_size / 2; ++i)
+        {
+            even[i] = secret[i * 2];
+            odd[i] = secret[i * 2 + 1];
+        }
+
+        Botan::SHA_1 sha;
+        sha.update(even.data(), even.size());
+        auto even_hash = sha.final();
+        sha.update(odd.data(), odd.size());
+        auto odd_hash = sha.final();
+
+        std::array<uint8, session_key_size> K{};
+        for (size_t i = 0; i < proof_size; ++i)
+        {
+            K[i * 2] = even_hash[i];
+            K[i * 2 + 1] = odd_hash[i];
+        }
+
+        return from_little_endian(K.data(), K.size());
+    }
+
+    Botan::BigInt private_key(std::string const& username, std::string const& password, Botan::BigInt const& salt)
+    {
+        Botan::SHA_1 sha;
+        sha.update(to_upper(username));
+        sha.update(":");
+        sha.update(to_upper(password));
+        auto credentials = sha.final();
+
+        sha.update(to_little_endian(salt, key_size));
+        sha.update(credentials);
+        auto hash = sha.final();
+
+        return from_little_endian(hash.data(), hash.size());
+    }
+
+    Botan::BigInt client_session_key(Botan::BigInt const& N, Botan::BigInt const& g, Botan::BigInt const& B,
+                                     Botan::BigInt const& a, Botan::BigInt const& A, Botan::BigInt const& x)
+    {
+        Botan::BigInt const k{3};
+
+        auto u = scrambler(A, B);
+        auto kgx = (k * Botan::power_mod(g, x, N)) % N;
+        auto base = (B + N * k - kgx) % N;
+        auto S = Botan::power_mod(base, a + u * x, N);
+
+        return interleaved_session_key(S);
+    }
+
+    Botan::BigInt server_session_key(Botan::BigInt const& N, Botan::BigInt const& v, Botan::BigInt const& A,
+                                     Botan::BigInt const& b, Botan::BigInt const& B)
+    {
+        auto u = scrambler(A, B);
+        auto S = Botan::power_mod((A * Botan::power_mod(v, u, N)) % N, b, N);
+
+        return interleaved_session_key(S);
+    }
+
+    Botan::BigInt client_proof(Botan::BigInt const& N, Botan::BigInt const& g, Botan::BigInt const& salt,
+                               std::string const& username, Botan::BigInt const& A, Botan::BigInt const& B,
+                               Botan::BigInt const& K)
+    {
+        Botan::SHA_1 sha;
+        sha.update(to_little_endian(N, key_size));
+        auto N_hash = sha.final();
+        sha.update(to_little_endian(g, g.bytes()));
+        auto g_hash = sha.final();
+
+        for (size_t i = 0; i < N_hash.size(); ++i)
+            N_hash[i] ^= g_hash[i];
+
+        sha.update(username);
+        auto username_hash = sha.final();
+
+        sha.update(N_hash);
+        sha.update(username_hash);
+        sha.update(to_little_endian(salt, key_size));
+        sha.update(to_little_endian(A, key_size));
+        sha.update(to_little_endian(B, key_size));
+        sha.update(to_little_endian(K, session_key_size));
+        auto hash = sha.final();
+
+        return from_little_endian(hash.data(), hash.size());
+    }
+
+    Botan::BigInt server_proof(Botan::BigInt const& A, Botan::BigInt const& M1, Botan::BigInt const& K)
+    {
+        Botan::SHA_1 sha;
+        sha.update(to_little_endian(A, key_size));
+        sha.update(to_little_endian(M1, proof_size));
+        sha.update(to_little_endian(K, session_key_size));
+        auto hash = sha.final();
+
+        return from_little_endian(hash.data(), hash.size());
+    }
+
+    server::server(Botan::BigInt const& N, Botan::BigInt const& g, Botan::BigInt const& verifier, ephemeral ephemeral)
+      : N_{N}
+      , g_{g}
+      , v_{verifier}
+      , b_{std::move(ephemeral.b)}
+    {
+        Botan::BigInt const k{3};
+        B_ = (k * v_ + ephemeral.g_b) % N_;
+    }
+
+    Botan::BigInt server::session_key(Botan::BigInt const& A)
+    {
+        // A must never be a multiple of N or the client could force a known session key
+        if ((A % N_).is_zero())
+            return Botan::BigInt{};
+
+        A_ = A;
+        return server_session_key(N_, v_, A_, b_, B_);
+    }
+
+    Botan::BigInt server::proof(Botan::BigInt const& M1, Botan::BigInt const& K) const
+    {
+        return server_proof(A_, M1, K);
+    }
+}
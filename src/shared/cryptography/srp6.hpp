@@ -0,0 +1,107 @@
+/*
+    Copyright 2018-2019 KeycapEmu
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#pragma once
+
+#include <keycap/root/types.hpp>
+
+#include <botan/bigint.h>
+
+#include <string>
+#include <vector>
+
+// SRP6 building blocks that aren't exposed by keycap::root::network::srp6.
+// All values follow the compliance::Wow conventions: numbers are transferred and hashed in little endian byte order and
+// every Botan::BigInt holds the little endian interpretation of its wire representation.
+namespace keycap::shared::cryptography::srp6
+{
+    // Returns the given value as little endian byte sequence of the given size
+    std::vector<uint8> to_little_endian(Botan::BigInt const& value, size_t size);
+
+    // Returns the value of the given little endian byte sequence
+    Botan::BigInt from_little_endian(uint8 const* data, size_t size);
+
+    // Returns the scrambling parameter u = H(A | B)
+    Botan::BigInt scrambler(Botan::BigInt const& A, Botan::BigInt const& B);
+
+    // Returns the session key K by hashing the even and odd bytes of the given premaster secret S separately
+    Botan::BigInt interleaved_session_key(Botan::BigInt const& S);
+
+    // Returns the user's private key x = H(s | H(upper(I) | ':' | upper(P)))
+    Botan::BigInt private_key(std::string const& username, std::string const& password, Botan::BigInt const& salt);
+
+    // Returns the client's session key K for the given server's public ephemeral value B
+    Botan::BigInt client_session_key(Botan::BigInt const& N, Botan::BigInt const& g, Botan::BigInt const& B,
+                                     Botan::BigInt const& a, Botan::BigInt const& A, Botan::BigInt const& x);
+
+    // Returns the server's session key K for the given client's public ephemeral value A
+    Botan::BigInt server_session_key(Botan::BigInt const& N, Botan::BigInt const& v, Botan::BigInt const& A,
+                                     Botan::BigInt const& b, Botan::BigInt const& B);
+
+    // Returns the client's proof M1 = H(H(N) xor H(g) | H(I) | s | A | B | K)
+    Botan::BigInt client_proof(Botan::BigInt const& N, Botan::BigInt const& g, Botan::BigInt const& salt,
+                               std::string const& username, Botan::BigInt const& A, Botan::BigInt const& B,
+                               Botan::BigInt const& K);
+
+    // Returns the server's proof M2 = H(A | M1 | K)
+    Botan::BigInt server_proof(Botan::BigInt const& A, Botan::BigInt const& M1, Botan::BigInt const& K);
+
+    // A precomputed server ephemeral. g_b is g^b mod N; B still needs the verifier dependent kv term
+    struct ephemeral
+    {
+        Botan::BigInt b;
+        Botan::BigInt g_b;
+    };
+
+    // The server side of an SRP6 handshake using an ephemeral that has been computed ahead of time.
+    // Drop-in for keycap::root::network::srp6::server with compliance::Wow
+    class server
+    {
+      public:
+        server(Botan::BigInt const& N, Botan::BigInt const& g, Botan::BigInt const& verifier, ephemeral ephemeral);
+
+        // Returns the public ephemeral value B = kv + g^b mod N
+        Botan::BigInt const& public_ephemeral_value() const
+        {
+            return B_;
+        }
+
+        // Returns the session key K for the given client's public ephemeral value A or zero if A is invalid
+        Botan::BigInt session_key(Botan::BigInt const& A);
+
+        // Returns the server's proof M2 for the given client proof and session key. Requires session_key() to be called
+        // first
+        Botan::BigInt proof(Botan::BigInt const& M1, Botan::BigInt const& K) const;
+
+        Botan::BigInt const& prime() const
+        {
+            return N_;
+        }
+
+        Botan::BigInt const& generator() const
+        {
+            return g_;
+        }
+
+      private:
+        Botan::BigInt N_;
+        Botan::BigInt g_;
+        Botan::BigInt v_;
+        Botan::BigInt b_;
+        Botan::BigInt B_;
+        Botan::BigInt A_;
+    };
+}
@@ -14,11 +14,15 @@
     limitations under the License.
 */
 
+#pragma once
+
 #include <generated/character.hpp>
 #include <generated/character_select.hpp>
 
 #include <functional>
 #include <optional>
+#include <utility>
+#include <vector>
 
 namespace keycap::shared::database::dal
 {
@@ -28,20 +32,35 @@ namespace keycap::shared::database::dal
         virtual ~character_dao()
         {
         }
-        
-        // Retreives the highest character id
-        // This will block the thread until the operation is finished!
-        virtual uint32 last_id() const = 0;
 
-        using character_callback = std::function<void(std::vector<shared::database::character>)>;
+        using reserve_ids_callback = std::function<void(std::optional<uint32> first)>;
+
+        // Reserves `count` consecutive character ids that won't be handed out to anyone else and then calls the given
+        // callback with the first of them
+        virtual void reserve_ids(uint32 count, reserve_ids_callback callback) const = 0;
+
+        using character_callback = std::function<void(std::optional<std::vector<shared::database::character>>)>;
 
         // Retreives all characters from the given realm with the given user id from the database and then calls the
-        // given callback
+        // given callback. The characters are empty if they couldn't be retreived
         virtual void realm_characters(uint8 realm, uint32 user, character_callback callback) const = 0;
 
         using create_character_callback = std::function<void(keycap::protocol::char_create_result result)>;
         virtual void create_character(uint8 realm, uint32 character, uint32 user, keycap::protocol::char_data const& data, create_character_callback callback) const = 0;
 
         virtual void delete_character(uint32 character) const = 0;
+
+        using delete_character_callback = std::function<void(bool success)>;
+
+        // Deletes the given character if it belongs to the given user on the given realm and then calls the given
+        // callback
+        virtual void delete_realm_character(uint8 realm, uint32 user, uint32 character,
+                                            delete_character_callback callback) const = 0;
+
+        using character_counts_callback = std::function<void(std::vector<std::pair<uint8, uint8>>)>;
+
+        // Retreives the number of characters the given user has on each realm and then calls the given callback with
+        // a list of (realm, count) pairs
+        virtual void character_counts(uint32 user, character_counts_callback callback) const = 0;
     };
 }
\ No newline at end of file
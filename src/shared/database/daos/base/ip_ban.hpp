@@ -0,0 +1,38 @@
+/*
+    Copyright 2018-2019 KeycapEmu
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#pragma once
+
+#include <generated/ip_ban.hpp>
+
+#include <functional>
+#include <vector>
+
+namespace keycap::shared::database::dal
+{
+    class ip_ban_dao
+    {
+      public:
+        virtual ~ip_ban_dao()
+        {
+        }
+
+        using ip_bans_callback = std::function<void(std::vector<shared::database::ip_ban>)>;
+
+        // Retreives all bans that haven't expired yet and then calls the given callback
+        virtual void active_bans(ip_bans_callback callback) const = 0;
+    };
+}
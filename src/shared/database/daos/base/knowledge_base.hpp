@@ -14,12 +14,57 @@
     limitations under the License.
 */
 
+#pragma once
+
 #include <generated/knowledge_base.hpp>
 
 #include <functional>
 #include <optional>
 #include <unordered_set>
 
+namespace std
+{
+    template <>
+    struct hash<keycap::shared::database::sub_category>
+    {
+        inline size_t operator()(const keycap::shared::database::sub_category& cat) const
+        {
+            std::hash<int> int_hasher;
+            return int_hasher(cat.id) ^ int_hasher(cat.category);
+        }
+    };
+
+    template <>
+    struct hash<keycap::shared::database::category>
+    {
+        inline size_t operator()(const keycap::shared::database::category& cat) const
+        {
+            std::hash<int> int_hasher;
+            return int_hasher(cat.id);
+        }
+    };
+
+    template <>
+    struct equal_to<keycap::shared::database::sub_category>
+    {
+        constexpr bool operator()(const keycap::shared::database::sub_category& lhs,
+                                  const keycap::shared::database::sub_category& rhs) const
+        {
+            return lhs.id == rhs.id && lhs.category == rhs.category;
+        }
+    };
+
+    template <>
+    struct equal_to<keycap::shared::database::category>
+    {
+        constexpr bool operator()(const keycap::shared::database::category& lhs,
+                                  const keycap::shared::database::category& rhs) const
+        {
+            return lhs.id == rhs.id;
+        }
+    };
+}
+
 namespace keycap::shared::database::dal
 {
     struct kb_data;
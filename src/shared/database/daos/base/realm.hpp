@@ -14,6 +14,8 @@
     limitations under the License.
 */
 
+#pragma once
+
 #include <generated/realm.hpp>
 
 #include <functional>
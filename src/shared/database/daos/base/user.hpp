@@ -14,10 +14,14 @@
     limitations under the License.
 */
 
+#pragma once
+
 #include <generated/user.hpp>
 
 #include <functional>
 #include <optional>
+#include <string>
+#include <vector>
 
 namespace keycap::shared::database::dal
 {
@@ -30,10 +34,15 @@ namespace keycap::shared::database::dal
 
         using user_callback = std::function<void(std::optional<shared::database::user>)>;
         using user_id_callback = std::function<void(std::optional<int>)>;
+        using users_callback = std::function<void(std::optional<std::vector<shared::database::user>>)>;
 
         // Retreives the user with the given username from the database and then calls the given callback
         virtual void user(std::string const& username, user_callback callback) const = 0;
 
+        // Retreives all users with one of the given usernames with a single query and then calls the given callback.
+        // Usernames that don't exist are missing from the result. The result is empty if the query failed
+        virtual void users(std::vector<std::string> const& usernames, users_callback callback) const = 0;
+
         // Creates a new user in the database from the given user
         virtual void create(shared::database::user const& user) const = 0;
 
@@ -14,10 +14,13 @@
     limitations under the License.
 */
 
+#pragma once
+
 #include <generated/user_telemetry.hpp>
 
 #include <functional>
 #include <optional>
+#include <vector>
 
 namespace keycap::shared::database::dal
 {
@@ -28,6 +31,11 @@ namespace keycap::shared::database::dal
         {
         }
 
-        virtual void add_telemetry_data(std::string const& account_name, std::string const& data) = 0;
+        using add_telemetry_callback = std::function<void(bool success)>;
+
+        // Inserts all given entries at once and calls the given callback from a database thread.
+        // Entries that already exist are skipped instead of failing the whole batch
+        virtual void add_telemetry(std::vector<shared::database::user_telemetry> entries,
+                                   add_telemetry_callback callback) = 0;
     };
 }
\ No newline at end of file
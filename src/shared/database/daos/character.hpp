@@ -14,4 +14,19 @@
     limitations under the License.
 */
 
-#include "mysql/character.hpp"
\ No newline at end of file
+#pragma once
+
+#include "memory/character.hpp"
+#include "mysql/character.hpp"
+
+namespace keycap::shared::database::dal
+{
+    // Returns the character dao of the database's backend
+    inline std::unique_ptr<character_dao> get_character_dao(database& database)
+    {
+        if (database.backend() == database_backend::memory)
+            return get_memory_character_dao(database);
+
+        return get_mysql_character_dao(database);
+    }
+}
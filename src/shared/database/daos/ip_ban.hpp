@@ -0,0 +1,32 @@
+/*
+    Copyright 2018-2019 KeycapEmu
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#pragma once
+
+#include "memory/ip_ban.hpp"
+#include "mysql/ip_ban.hpp"
+
+namespace keycap::shared::database::dal
+{
+    // Returns the ip_ban dao of the database's backend
+    inline std::unique_ptr<ip_ban_dao> get_ip_ban_dao(database& database)
+    {
+        if (database.backend() == database_backend::memory)
+            return get_memory_ip_ban_dao(database);
+
+        return get_mysql_ip_ban_dao(database);
+    }
+}
@@ -14,4 +14,19 @@
     limitations under the License.
 */
 
-#include "mysql/knowledge_base.hpp"
\ No newline at end of file
+#pragma once
+
+#include "memory/knowledge_base.hpp"
+#include "mysql/knowledge_base.hpp"
+
+namespace keycap::shared::database::dal
+{
+    // Returns the knowledge_base dao of the database's backend
+    inline std::unique_ptr<knowledge_base_dao> get_knowledge_base_dao(database& database)
+    {
+        if (database.backend() == database_backend::memory)
+            return get_memory_knowledge_base_dao(database);
+
+        return get_mysql_knowledge_base_dao(database);
+    }
+}
@@ -0,0 +1,160 @@
+/*
+    Copyright 2018-2019 KeycapEmu
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "./character.hpp"
+#include "../../../string_utility.hpp"
+
+#include <algorithm>
+#include <map>
+
+namespace keycap::shared::database::dal
+{
+    class memory_character_dao final : public character_dao
+    {
+      public:
+        memory_character_dao(database& database)
+          : database_{database}
+          , store_{database.memory_store()}
+        {
+        }
+
+        void reserve_ids(uint32 count, reserve_ids_callback callback) const override
+        {
+            database_.work_service().post(
+                [&store = store_, count, callback] { callback(store.next_character_id.fetch_add(count)); });
+        }
+
+        void realm_characters(uint8 realm, uint32 user, character_callback callback) const override
+        {
+            database_.work_service().post([&store = store_, realm, user, callback] {
+                std::vector<uint32> ids;
+                store.realm_characters.for_each([&](uint32 id, realm_character const& entry) {
+                    if (entry.realm == realm && entry.account == user)
+                        ids.emplace_back(id);
+                });
+
+                std::sort(ids.begin(), ids.end());
+
+                std::vector<shared::database::character> characters;
+                for (auto id : ids)
+                {
+                    if (auto character = store.characters.find(id))
+                        characters.emplace_back(std::move(*character));
+                }
+
+                callback(std::move(characters));
+            });
+        }
+
+        void create_character(uint8 realm, uint32 character, uint32 user, keycap::protocol::char_data const& data,
+                              create_character_callback callback) const override
+        {
+            database_.work_service().post([&store = store_, realm, character, user, data, callback] {
+                // Reserving the name first makes the check and the insert one atomic step
+                if (store.characters.contains(character)
+                    || !store.character_names.insert(name_key(realm, data.name), character))
+                    return callback(keycap::protocol::char_create_result::name_unavailable);
+
+                store.characters.insert(character, shared::database::character{
+                                                       character,
+                                                       data.name,
+                                                       data.race,
+                                                       data.player_class,
+                                                       data.gender,
+                                                       data.skin,
+                                                       data.face,
+                                                       data.hair_style,
+                                                       data.hair_color,
+                                                       data.facial_hair,
+                                                       data.level,
+                                                       data.zone,
+                                                       data.map,
+                                                       data.x,
+                                                       data.y,
+                                                       data.z,
+                                                       data.guild_id,
+                                                       data.flags,
+                                                       data.first_login,
+                                                       data.pet_display_id,
+                                                   });
+                store.realm_characters.insert(character, realm_character{realm, character, user, data.name});
+
+                callback(keycap::protocol::char_create_result::success);
+            });
+        }
+
+        void delete_character(uint32 character) const override
+        {
+            database_.work_service().post([&store = store_, character] { erase(store, character); });
+        }
+
+        void delete_realm_character(uint8 realm, uint32 user, uint32 character,
+                                    delete_character_callback callback) const override
+        {
+            database_.work_service().post([&store = store_, realm, user, character, callback] {
+                auto entry = store.realm_characters.find(character);
+                if (!entry || entry->realm != realm || entry->account != user)
+                    return callback(false);
+
+                erase(store, character);
+                callback(true);
+            });
+        }
+
+        void character_counts(uint32 user, character_counts_callback callback) const override
+        {
+            database_.work_service().post([&store = store_, user, callback] {
+                std::map<uint8, uint32> counts;
+                store.realm_characters.for_each([&](uint32, realm_character const& entry) {
+                    if (entry.account == user)
+                        ++counts[entry.realm];
+                });
+
+                std::vector<std::pair<uint8, uint8>> result;
+                for (auto const& [realm, count] : counts)
+                    result.emplace_back(realm, static_cast<uint8>(std::min(count, 255u)));
+
+                callback(std::move(result));
+            });
+        }
+
+      private:
+        // Compares names case insensitive like the unique (realm, name) index of realm_character does
+        static std::string name_key(uint8 realm, std::string name)
+        {
+            return std::to_string(realm) + ":" + to_upper(std::move(name));
+        }
+
+        static void erase(memory::store& store, uint32 character)
+        {
+            auto entry = store.realm_characters.find(character);
+            auto data = store.characters.find(character);
+            if (entry && data)
+                store.character_names.erase(name_key(entry->realm, data->name));
+
+            store.realm_characters.erase(character);
+            store.characters.erase(character);
+        }
+
+        database& database_;
+        memory::store& store_;
+    };
+
+    std::unique_ptr<character_dao> get_memory_character_dao(database& database)
+    {
+        return std::make_unique<memory_character_dao>(database);
+    }
+}
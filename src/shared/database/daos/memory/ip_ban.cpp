@@ -0,0 +1,56 @@
+/*
+    Copyright 2018-2019 KeycapEmu
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "./ip_ban.hpp"
+
+#include <ctime>
+
+namespace keycap::shared::database::dal
+{
+    class memory_ip_ban_dao final : public ip_ban_dao
+    {
+      public:
+        memory_ip_ban_dao(database& database)
+          : database_{database}
+          , store_{database.memory_store()}
+        {
+        }
+
+        void active_bans(ip_bans_callback callback) const override
+        {
+            database_.work_service().post([&store = store_, callback] {
+                auto now = static_cast<uint64>(time(nullptr));
+
+                std::vector<shared::database::ip_ban> bans;
+                store.ip_bans.for_each([&](uint32, shared::database::ip_ban const& ban) {
+                    if (ban.unban_date == 0 || ban.unban_date > now)
+                        bans.emplace_back(ban);
+                });
+
+                callback(std::move(bans));
+            });
+        }
+
+      private:
+        database& database_;
+        memory::store& store_;
+    };
+
+    std::unique_ptr<ip_ban_dao> get_memory_ip_ban_dao(database& database)
+    {
+        return std::make_unique<memory_ip_ban_dao>(database);
+    }
+}
@@ -0,0 +1,86 @@
+/*
+    Copyright 2018-2019 KeycapEmu
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "./knowledge_base.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <sstream>
+
+namespace keycap::shared::database::dal
+{
+    class memory_knowledge_base final : public knowledge_base_dao
+    {
+      public:
+        memory_knowledge_base(database& database)
+          : store_{database.memory_store()}
+        {
+        }
+
+        kb_data load_data() const override
+        {
+            kb_data data;
+            store_.categories.for_each([&](int32 id, category const& category) {
+                category_data entry{category, {}};
+                if (auto subs = store_.sub_categories.find(id))
+                    entry.subcategories = std::move(*subs);
+
+                data.categories.emplace_back(std::move(entry));
+            });
+
+            store_.articles.for_each([&](int32, article const& article) { data.articles.emplace_back(article); });
+
+            return data;
+        }
+
+        // Stands in for MySQL's full text search by returning the articles that contain all of the query's words
+        std::vector<article> query_articles(std::string const& query, int category) const override
+        {
+            std::vector<std::string> words;
+            std::istringstream stream{lower(query)};
+            for (std::string word; stream >> word;)
+                words.emplace_back(word);
+
+            std::vector<article> articles;
+            store_.articles.for_each([&](int32, article const& article) {
+                if (category && article.category != category)
+                    return;
+
+                auto text = lower(article.subject + " " + article.text);
+                if (std::all_of(words.begin(), words.end(),
+                                [&](auto const& word) { return text.find(word) != std::string::npos; }))
+                    articles.emplace_back(article);
+            });
+
+            return articles;
+        }
+
+      private:
+        static std::string lower(std::string value)
+        {
+            std::transform(value.begin(), value.end(), value.begin(),
+                           [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+            return value;
+        }
+
+        memory::store& store_;
+    };
+
+    std::unique_ptr<knowledge_base_dao> get_memory_knowledge_base_dao(database& database)
+    {
+        return std::make_unique<memory_knowledge_base>(database);
+    }
+}
@@ -0,0 +1,44 @@
+/*
+    Copyright 2018-2019 KeycapEmu
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "./realm.hpp"
+
+namespace keycap::shared::database::dal
+{
+    class memory_realm_dao final : public realm_dao
+    {
+      public:
+        memory_realm_dao(database& database)
+          : database_{database}
+          , store_{database.memory_store()}
+        {
+        }
+
+        void realm(uint8 id, realm_callback callback) const override
+        {
+            database_.work_service().post([&store = store_, id, callback] { callback(store.realms.find(id)); });
+        }
+
+      private:
+        database& database_;
+        memory::store& store_;
+    };
+
+    std::unique_ptr<realm_dao> get_memory_realm_dao(database& database)
+    {
+        return std::make_unique<memory_realm_dao>(database);
+    }
+}
@@ -0,0 +1,101 @@
+/*
+    Copyright 2018-2019 KeycapEmu
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "./user.hpp"
+#include "../../../string_utility.hpp"
+
+namespace keycap::shared::database::dal
+{
+    class memory_user_dao final : public user_dao
+    {
+      public:
+        memory_user_dao(database& database)
+          : database_{database}
+          , store_{database.memory_store()}
+        {
+        }
+
+        void user(std::string const& username, user_callback callback) const override
+        {
+            database_.work_service().post(
+                [&store = store_, key = key_of(username), callback] { callback(store.users.find(key)); });
+        }
+
+        void users(std::vector<std::string> const& usernames, users_callback callback) const override
+        {
+            database_.work_service().post([&store = store_, usernames, callback] {
+                std::vector<shared::database::user> users;
+                for (auto const& username : usernames)
+                {
+                    if (auto user = store.users.find(key_of(username)))
+                        users.emplace_back(std::move(*user));
+                }
+
+                callback(std::move(users));
+            });
+        }
+
+        void create(shared::database::user const& user) const override
+        {
+            database_.work_service().post([&store = store_, user] {
+                auto copy = user;
+                copy.id = store.next_user_id++;
+                store.users.insert(key_of(user.account_name), std::move(copy));
+            });
+        }
+
+        void update_session_key(std::string const& account_name, std::string const& session_key) const override
+        {
+            database_.work_service().post([&store = store_, key = key_of(account_name), session_key] {
+                store.users.update(key, [&](shared::database::user& user) { user.session_key = session_key; });
+            });
+        }
+
+        std::optional<std::string> session_key(std::string const& account_name) const override
+        {
+            auto user = store_.users.find(key_of(account_name));
+            if (!user)
+                return std::nullopt;
+
+            return user->session_key;
+        }
+
+        void user_id_from_username(std::string const& username, user_id_callback callback) const override
+        {
+            database_.work_service().post([&store = store_, key = key_of(username), callback] {
+                auto user = store.users.find(key);
+                if (!user)
+                    return callback(std::nullopt);
+
+                callback(user->id);
+            });
+        }
+
+      private:
+        static std::string key_of(std::string name)
+        {
+            return to_upper(std::move(name));
+        }
+
+        database& database_;
+        memory::store& store_;
+    };
+
+    std::unique_ptr<user_dao> get_memory_user_dao(database& database)
+    {
+        return std::make_unique<memory_user_dao>(database);
+    }
+}
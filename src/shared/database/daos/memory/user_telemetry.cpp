@@ -0,0 +1,61 @@
+/*
+    Copyright 2018-2019 KeycapEmu
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "./user_telemetry.hpp"
+
+#include <algorithm>
+
+namespace keycap::shared::database::dal
+{
+    class memory_user_telemetry_dao final : public user_telemetry_dao
+    {
+      public:
+        memory_user_telemetry_dao(database& database)
+          : database_{database}
+          , store_{database.memory_store()}
+        {
+        }
+
+        void add_telemetry(std::vector<user_telemetry> entries, add_telemetry_callback callback) override
+        {
+            database_.work_service().post(
+                [&store = store_, entries = std::move(entries), callback = std::move(callback)] {
+                    for (auto const& entry : entries)
+                    {
+                        store.telemetry.upsert(entry.id, [&](std::vector<user_telemetry>& existing) {
+                            auto duplicate = std::any_of(existing.begin(), existing.end(), [&](auto const& other) {
+                                return other.date_taken == entry.date_taken;
+                            });
+
+                            if (!duplicate)
+                                existing.emplace_back(entry);
+                        });
+                    }
+
+                    callback(true);
+                });
+        }
+
+      private:
+        database& database_;
+        memory::store& store_;
+    };
+
+    std::unique_ptr<user_telemetry_dao> get_memory_user_telemetry_dao(database& database)
+    {
+        return std::make_unique<memory_user_telemetry_dao>(database);
+    }
+}
@@ -18,9 +18,15 @@
 
 #include "../../database.hpp"
 #include "../../prepared_statement.hpp"
+#include "../../transaction.hpp"
+
+#include <algorithm>
 
 namespace keycap::shared::database::dal
 {
+    // MySQL error for an insert that violates a primary key or unique index
+    constexpr int duplicate_entry_error = 1062;
+
     class mysql_character_dao final : public character_dao
     {
       public:
@@ -29,60 +35,39 @@ namespace keycap::shared::database::dal
         {
         }
 
-        virtual uint32 last_id() const override
+        void reserve_ids(uint32 count, reserve_ids_callback callback) const override
         {
-            static auto statement = database_.prepare_statement("SELECT MAX(`id`) "
-                                                                "FROM `character` ");
-
-            auto result = statement.query();
-            if (!result || !result->next())
-                return 0;
-
-            return result->getUInt("MAX(`id`)");
+            database_.work_service().post([&database = database_, count, callback] {
+                try
+                {
+                    callback(reserve_id_block(database, count));
+                }
+                catch (...)
+                {
+                    callback(std::nullopt);
+                }
+            });
         }
 
         void realm_characters(uint8 realm, uint32 user, character_callback callback) const override
         {
-            static auto statement = database_.prepare_statement("SELECT c.*, i.* "
-                                                                "from realm_character r "
-                                                                "INNER JOIN `character` c ON r.`character` = c.id "
-                                                                "LEFT JOIN character_item i ON i.`character` = c.id "
-                                                                "WHERE account = ? AND realm = ?;");
+            auto statement = database_.prepare_statement("SELECT c.* "
+                                                         "FROM realm_character r "
+                                                         "INNER JOIN `character` c ON r.`character` = c.id "
+                                                         "WHERE account = ? AND realm = ? "
+                                                         "ORDER BY c.id;");
             statement.add_parameter(user);
             statement.add_parameter(realm);
 
-            auto whenDone = [callback](std::unique_ptr<sql::ResultSet> result) {
-                if (!result || !result->next())
-                    return callback({});
+            auto whenDone = [callback](std::unique_ptr<result_set> result) {
+                if (!result)
+                    return callback(std::nullopt);
 
                 std::vector<shared::database::character> characters;
-                do
-                {
-                    characters.emplace_back(shared::database::character{
-                        static_cast<uint32>(result->getUInt("id")),
-                        result->getString("name").c_str(),
-                        static_cast<uint8>(result->getUInt("race")),
-                        static_cast<uint8>(result->getUInt("player_class")),
-                        static_cast<uint8>(result->getUInt("gender")),
-                        static_cast<uint8>(result->getUInt("skin")),
-                        static_cast<uint8>(result->getUInt("face")),
-                        static_cast<uint8>(result->getUInt("hair_style")),
-                        static_cast<uint8>(result->getUInt("hair_color")),
-                        static_cast<uint8>(result->getUInt("facial_hair")),
-                        static_cast<uint8>(result->getUInt("level")),
-                        static_cast<uint32>(result->getUInt("zone")),
-                        static_cast<uint32>(result->getUInt("map")),
-                        static_cast<float>(result->getUInt("x")),
-                        static_cast<float>(result->getUInt("y")),
-                        static_cast<float>(result->getUInt("z")),
-                        static_cast<uint32>(result->getUInt("guild")),
-                        static_cast<uint32>(result->getUInt("flags")),
-                        static_cast<uint8>(result->getUInt("first_login")),
-                        static_cast<uint32>(result->getUInt("active_pet")),
-                        // std::vector<character_item> items;
-                    });
-                } while (result->next());
-                callback(characters);
+                while (result->next())
+                    characters.emplace_back(from_result(*result));
+
+                callback(std::move(characters));
             };
 
             statement.query_async(whenDone);
@@ -92,82 +77,60 @@ namespace keycap::shared::database::dal
                                       keycap::protocol::char_data const& data,
                                       create_character_callback callback) const override
         {
-            static auto statement = database_.prepare_statement("SELECT c.*, r. * "
-                                                                "FROM realm_character r "
-                                                                "INNER JOIN `character` c ON r.`character` = c.id "
-                                                                "WHERE (realm = ? AND name = ?) OR id = ?;");
-
-            static auto create_character = database_.prepare_statement(
+            auto create_character = database_.prepare_statement(
                 "INSERT INTO `character`(id, name, race, player_class, gender, skin, face, hair_style, hair_color, "
                 "facial_hair, level, zone, map, x, y, z, guild, flags, first_login, active_pet) VALUES "
                 "( ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?);");
 
-            static auto create_realm_character = database_.prepare_statement("INSERT INTO realm_character VALUES "
-                                                                             "( ?, ?, ? );");
-
-            statement.add_parameter(realm);
-            statement.add_parameter(data.name);
-            statement.add_parameter(character);
-
-            auto whenDone = [callback, data, this, realm, character, user](std::unique_ptr<sql::ResultSet> result) {
-                if (!result || result->next())
+            create_character.add_parameter(character);
+            create_character.add_parameter(data.name);
+            create_character.add_parameter(data.race);
+            create_character.add_parameter(data.player_class);
+            create_character.add_parameter(data.gender);
+            create_character.add_parameter(data.skin);
+            create_character.add_parameter(data.face);
+            create_character.add_parameter(data.hair_style);
+            create_character.add_parameter(data.hair_color);
+            create_character.add_parameter(data.facial_hair);
+            create_character.add_parameter(data.level);
+            create_character.add_parameter(data.zone);
+            create_character.add_parameter(data.map);
+            create_character.add_parameter(data.x);
+            create_character.add_parameter(data.y);
+            create_character.add_parameter(data.z);
+            create_character.add_parameter(data.guild_id);
+            create_character.add_parameter(data.flags);
+            create_character.add_parameter(data.first_login);
+            create_character.add_parameter(data.pet_display_id);
+
+            auto create_realm_character = database_.prepare_statement(
+                "INSERT INTO realm_character (realm, `character`, account, name) VALUES ( ?, ?, ?, ? );");
+            create_realm_character.add_parameter(realm);
+            create_realm_character.add_parameter(character);
+            create_realm_character.add_parameter(user);
+            create_realm_character.add_parameter(data.name);
+
+            auto transaction = database_.begin_transaction();
+            transaction.add(std::move(create_character));
+            transaction.add(std::move(create_realm_character));
+
+            transaction.commit_async([callback](int error) {
+                if (error == 0)
+                    return callback(keycap::protocol::char_create_result::success);
+
+                // Taken names are rejected by the unique (realm, name) index of realm_character
+                if (error == duplicate_entry_error)
                     return callback(keycap::protocol::char_create_result::name_unavailable);
 
-                create_character.add_parameter(character);
-                create_character.add_parameter(data.name);
-                create_character.add_parameter(data.race);
-                create_character.add_parameter(data.player_class);
-                create_character.add_parameter(data.gender);
-                create_character.add_parameter(data.skin);
-                create_character.add_parameter(data.face);
-                create_character.add_parameter(data.hair_style);
-                create_character.add_parameter(data.hair_color);
-                create_character.add_parameter(data.facial_hair);
-                create_character.add_parameter(data.level);
-                create_character.add_parameter(data.zone);
-                create_character.add_parameter(data.map);
-                create_character.add_parameter(data.x);
-                create_character.add_parameter(data.y);
-                create_character.add_parameter(data.z);
-                create_character.add_parameter(data.guild_id);
-                create_character.add_parameter(data.flags);
-                create_character.add_parameter(data.first_login);
-                create_character.add_parameter(data.pet_display_id);
-
-                auto when_created = [this, realm, character, user, callback](bool success) {
-                    if (!success)
-                        return callback(keycap::protocol::char_create_result::failed);
-
-                    create_realm_character.add_parameter(realm);
-                    create_realm_character.add_parameter(character);
-                    create_realm_character.add_parameter(user);
-
-                    auto when_realm_char_created = [this, character, callback](bool success) {
-                        if (!success)
-                        {
-                            delete_character(character);
-                            return callback(keycap::protocol::char_create_result::error);
-                        }
-
-                        callback(keycap::protocol::char_create_result::success);
-                    };
-
-                    create_realm_character.execute_async(when_realm_char_created);
-                };
-
-                create_character.execute_async(when_created);
-
-                //
-            };
-
-            statement.query_async(whenDone);
+                callback(keycap::protocol::char_create_result::error);
+            });
         }
 
         virtual void delete_character(uint32 character) const override
         {
-            static auto delete_realm_character
+            auto delete_realm_character
                 = database_.prepare_statement("DELETE from realm_character WHERE `character` = ?");
-            static auto delete_character = database_.prepare_statement("DELETE from `character` WHERE id = ?");
+            auto delete_character = database_.prepare_statement("DELETE from `character` WHERE id = ?");
 
             delete_realm_character.add_parameter(character);
             delete_character.add_parameter(character);
@@ -176,11 +139,114 @@ namespace keycap::shared::database::dal
             delete_character.execute_async();
         }
 
+        void delete_realm_character(uint8 realm, uint32 user, uint32 character,
+                                    delete_character_callback callback) const override
+        {
+            // realm_character and character_item rows are removed by their ON DELETE CASCADE
+            auto statement = database_.prepare_statement("DELETE FROM `character` "
+                                                         "WHERE id = ? AND EXISTS (SELECT 1 FROM realm_character "
+                                                         "WHERE realm = ? AND account = ? AND `character` = ?)");
+
+            statement.add_parameter(character);
+            statement.add_parameter(realm);
+            statement.add_parameter(user);
+            statement.add_parameter(character);
+
+            statement.execute_async(std::move(callback));
+        }
+
+        void character_counts(uint32 user, character_counts_callback callback) const override
+        {
+            auto statement = database_.prepare_statement("SELECT realm, COUNT(*) AS count "
+                                                         "FROM realm_character "
+                                                         "WHERE account = ? "
+                                                         "GROUP BY realm;");
+            statement.add_parameter(user);
+
+            auto whenDone = [callback](std::unique_ptr<result_set> result) {
+                std::vector<std::pair<uint8, uint8>> counts;
+
+                while (result && result->next())
+                {
+                    counts.emplace_back(static_cast<uint8>(result->getUInt("realm")),
+                                        static_cast<uint8>(std::min(result->getUInt("count"), 255u)));
+                }
+
+                callback(counts);
+            };
+
+            statement.query_async(whenDone);
+        }
+
       private:
+        // Moves the start of the character id block forward by `count` and returns its previous value. The update only
+        // succeeds if no other accountserver moved it in the meantime, otherwise it starts over
+        static std::optional<uint32> reserve_id_block(database& database, uint32 count)
+        {
+            constexpr int max_attempts = 8;
+
+            for (int attempt = 0; attempt < max_attempts; ++attempt)
+            {
+                auto select = database.prepare_statement("SELECT next_id FROM id_block WHERE name = 'character';");
+
+                auto result = select.query();
+                if (!result)
+                    return std::nullopt;
+
+                if (!result->next())
+                {
+                    // Only the very first reservation has to look at the existing characters
+                    auto seed = database.prepare_statement("INSERT IGNORE INTO id_block (name, next_id) "
+                                                           "SELECT 'character', COALESCE(MAX(id), 0) + 1 "
+                                                           "FROM `character`;");
+                    seed.execute();
+                    continue;
+                }
+
+                auto first = static_cast<uint32>(result->getUInt("next_id"));
+
+                auto update = database.prepare_statement("UPDATE id_block SET next_id = ? "
+                                                         "WHERE name = 'character' AND next_id = ?;");
+                update.add_parameter(first + count);
+                update.add_parameter(first);
+
+                if (update.execute())
+                    return first;
+            }
+
+            return std::nullopt;
+        }
+
+        static shared::database::character from_result(result_set& result)
+        {
+            return shared::database::character{
+                static_cast<uint32>(result.getUInt("id")),
+                result.getString("name").c_str(),
+                static_cast<uint8>(result.getUInt("race")),
+                static_cast<uint8>(result.getUInt("player_class")),
+                static_cast<uint8>(result.getUInt("gender")),
+                static_cast<uint8>(result.getUInt("skin")),
+                static_cast<uint8>(result.getUInt("face")),
+                static_cast<uint8>(result.getUInt("hair_style")),
+                static_cast<uint8>(result.getUInt("hair_color")),
+                static_cast<uint8>(result.getUInt("facial_hair")),
+                static_cast<uint8>(result.getUInt("level")),
+                static_cast<uint32>(result.getUInt("zone")),
+                static_cast<uint32>(result.getUInt("map")),
+                static_cast<float>(result.getDouble("x")),
+                static_cast<float>(result.getDouble("y")),
+                static_cast<float>(result.getDouble("z")),
+                static_cast<uint32>(result.getUInt("guild")),
+                static_cast<uint32>(result.getUInt("flags")),
+                static_cast<uint8>(result.getUInt("first_login")),
+                static_cast<uint32>(result.getUInt("active_pet")),
+            };
+        }
+
         database& database_;
     };
 
-    std::unique_ptr<character_dao> get_character_dao(database& database)
+    std::unique_ptr<character_dao> get_mysql_character_dao(database& database)
     {
         return std::make_unique<mysql_character_dao>(database);
     }
@@ -14,6 +14,8 @@
     limitations under the License.
 */
 
+#pragma once
+
 #include "../../database.hpp"
 #include "../base/character.hpp"
 
@@ -21,5 +23,5 @@
 
 namespace keycap::shared::database::dal
 {
-    std::unique_ptr<character_dao> get_character_dao(database& database);
+    std::unique_ptr<character_dao> get_mysql_character_dao(database& database);
 }
\ No newline at end of file
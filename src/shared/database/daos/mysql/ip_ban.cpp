@@ -0,0 +1,66 @@
+/*
+    Copyright 2018-2019 KeycapEmu
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "./ip_ban.hpp"
+
+#include "../../database.hpp"
+#include "../../prepared_statement.hpp"
+
+namespace keycap::shared::database::dal
+{
+    class mysql_ip_ban_dao final : public ip_ban_dao
+    {
+      public:
+        mysql_ip_ban_dao(database& database)
+          : database_{database}
+        {
+        }
+
+        void active_bans(ip_bans_callback callback) const override
+        {
+            auto statement = database_.prepare_statement(
+                "SELECT * FROM ip_ban WHERE unban_date = 0 OR unban_date > UNIX_TIMESTAMP();");
+
+            auto whenDone = [callback](std::unique_ptr<result_set> result) {
+                if (!result || !result->next())
+                    return callback({});
+
+                std::vector<shared::database::ip_ban> bans;
+                do
+                {
+                    bans.emplace_back(shared::database::ip_ban{
+                        static_cast<uint32>(result->getUInt("id")),
+                        result->getString("network").c_str(),
+                        static_cast<uint8>(result->getUInt("allow")),
+                        result->getString("reason").c_str(),
+                        static_cast<uint64>(result->getUInt64("unban_date")),
+                    });
+                } while (result->next());
+                callback(bans);
+            };
+
+            statement.query_async(whenDone);
+        }
+
+      private:
+        database& database_;
+    };
+
+    std::unique_ptr<ip_ban_dao> get_mysql_ip_ban_dao(database& database)
+    {
+        return std::make_unique<mysql_ip_ban_dao>(database);
+    }
+}
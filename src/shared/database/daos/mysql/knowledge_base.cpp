@@ -19,49 +19,6 @@
 #include "../../Database.hpp"
 #include "../../prepared_statement.hpp"
 
-namespace std
-{
-    template <>
-    struct hash<keycap::shared::database::sub_category>
-    {
-        inline size_t operator()(const keycap::shared::database::sub_category& cat) const
-        {
-            std::hash<int> int_hasher;
-            return int_hasher(cat.id) ^ int_hasher(cat.category);
-        }
-    };
-
-    template <>
-    struct hash<keycap::shared::database::category>
-    {
-        inline size_t operator()(const keycap::shared::database::category& cat) const
-        {
-            std::hash<int> int_hasher;
-            return int_hasher(cat.id);
-        }
-    };
-
-    template <>
-    struct equal_to<keycap::shared::database::sub_category>
-    {
-        constexpr bool operator()(const keycap::shared::database::sub_category& lhs,
-                                  const keycap::shared::database::sub_category& rhs) const
-        {
-            return lhs.id == rhs.id && lhs.category == rhs.category;
-        }
-    };
-
-    template <>
-    struct equal_to<keycap::shared::database::category>
-    {
-        constexpr bool operator()(const keycap::shared::database::category& lhs,
-                                  const keycap::shared::database::category& rhs) const
-        {
-            return lhs.id == rhs.id;
-        }
-    };
-}
-
 namespace keycap::shared::database::dal
 {
     class mysql_knowledge_base final : public knowledge_base_dao
@@ -79,12 +36,12 @@ namespace keycap::shared::database::dal
 
         std::vector<article> query_articles(std::string const& query, int category) const override
         {
-            static auto statement
+            auto statement
                 = database_.prepare_statement("SELECT * FROM article WHERE MATCH (text) AGAINST (? IN BOOLEAN MODE)");
-            static auto statement_cat = database_.prepare_statement(
+            auto statement_cat = database_.prepare_statement(
                 "SELECT * FROM article WHERE MATCH (text) AGAINST (? IN BOOLEAN MODE) AND category = ?");
 
-            std::unique_ptr<sql::ResultSet> result;
+            std::unique_ptr<result_set> result;
             if (category)
             {
                 statement_cat.add_parameter(query);
@@ -122,7 +79,7 @@ namespace keycap::shared::database::dal
       private:
         std::vector<category_data> load_categories() const
         {
-            static auto statement = database_.prepare_statement(
+            auto statement = database_.prepare_statement(
                 "SELECT sub_category.id as sid, sub_category.name as sname, category.id as id, category.name as name "
                 "FROM sub_category "
                 "LEFT JOIN category "
@@ -155,7 +112,7 @@ namespace keycap::shared::database::dal
 
         std::vector<article> load_articles() const
         {
-            static auto statement = database_.prepare_statement("SELECT * FROM article");
+            auto statement = database_.prepare_statement("SELECT * FROM article");
 
             auto result = statement.query();
 
@@ -184,7 +141,7 @@ namespace keycap::shared::database::dal
         database& database_;
     };
 
-    std::unique_ptr<knowledge_base_dao> get_knowledge_base_dao(database& database)
+    std::unique_ptr<knowledge_base_dao> get_mysql_knowledge_base_dao(database& database)
     {
         return std::make_unique<mysql_knowledge_base>(database);
     }
@@ -31,10 +31,10 @@ namespace keycap::shared::database::dal
 
         void realm(uint8 id, realm_callback callback) const override
         {
-            static auto statement = database_.prepare_statement("SELECT * FROM realm WHERE id = ?");
+            auto statement = database_.prepare_statement("SELECT * FROM realm WHERE id = ?");
             statement.add_parameter(id);
 
-            auto whenDone = [callback](std::unique_ptr<sql::ResultSet> result) {
+            auto whenDone = [callback](std::unique_ptr<result_set> result) {
                 if (!result || !result->next())
                     return callback(std::nullopt);
 
@@ -60,7 +60,7 @@ namespace keycap::shared::database::dal
         database& database_;
     };
 
-    std::unique_ptr<realm_dao> get_realm_dao(database& database)
+    std::unique_ptr<realm_dao> get_mysql_realm_dao(database& database)
     {
         return std::make_unique<mysql_realm_dao>(database);
     }
@@ -19,6 +19,8 @@
 #include "../../database.hpp"
 #include "../../prepared_statement.hpp"
 
+#include <algorithm>
+
 namespace keycap::shared::database::dal
 {
     class mysql_user_dao final : public user_dao
@@ -31,22 +33,48 @@ namespace keycap::shared::database::dal
 
         void user(std::string const& username, user_callback callback) const override
         {
-            static auto statement = database_.prepare_statement("SELECT * FROM user WHERE account_name = ?");
+            auto statement = database_.prepare_statement("SELECT * FROM user WHERE account_name = ?");
             statement.add_parameter(username);
 
-            auto whenDone = [callback](std::unique_ptr<sql::ResultSet> result) {
+            auto whenDone = [callback](std::unique_ptr<result_set> result) {
                 if (!result || !result->next())
                     return callback(std::nullopt);
 
-                shared::database::user user{result->getUInt("id"),
-                                            result->getString("account_name").c_str(),
-                                            result->getString("email").c_str(),
-                                            static_cast<uint8>(result->getUInt("security_options")),
-                                            result->getUInt("flags"),
-                                            result->getString("verifier").c_str(),
-                                            result->getString("salt").c_str(),
-                                            result->getString("session_key").c_str()};
-                callback(user);
+                callback(from_result(*result));
+            };
+
+            statement.query_async(whenDone);
+        }
+
+        void users(std::vector<std::string> const& usernames, users_callback callback) const override
+        {
+            if (usernames.empty())
+                return callback(std::vector<shared::database::user>{});
+
+            // Round the number of placeholders up to the next power of two, so only a handful of distinct statements
+            // end up being prepared on every connection. The padding repeats the last name
+            size_t placeholders = 1;
+            while (placeholders < usernames.size())
+                placeholders *= 2;
+
+            std::string query = "SELECT * FROM user WHERE account_name IN (?";
+            for (size_t i = 1; i < placeholders; ++i)
+                query += ", ?";
+            query += ")";
+
+            auto statement = database_.prepare_statement(query);
+            for (size_t i = 0; i < placeholders; ++i)
+                statement.add_parameter(usernames[std::min(i, usernames.size() - 1)]);
+
+            auto whenDone = [callback](std::unique_ptr<result_set> result) {
+                if (!result)
+                    return callback(std::nullopt);
+
+                std::vector<shared::database::user> users;
+                while (result->next())
+                    users.emplace_back(from_result(*result));
+
+                callback(std::move(users));
             };
 
             statement.query_async(whenDone);
@@ -54,7 +82,7 @@ namespace keycap::shared::database::dal
 
         void create(shared::database::user const& user) const override
         {
-            static auto statement
+            auto statement
                 = database_.prepare_statement("INSERT INTO user(account_name, email, security_options, flags, "
                                               "verifier, salt) VALUES (?, ?, ?, ?, ?, ?)");
 
@@ -70,8 +98,7 @@ namespace keycap::shared::database::dal
 
         void update_session_key(std::string const& account_name, std::string const& session_key) const override
         {
-            static auto statement
-                = database_.prepare_statement("UPDATE user SET session_key = ? WHERE account_name = ?");
+            auto statement = database_.prepare_statement("UPDATE user SET session_key = ? WHERE account_name = ?");
 
             statement.add_parameter(session_key);
             statement.add_parameter(account_name);
@@ -81,7 +108,7 @@ namespace keycap::shared::database::dal
 
         std::optional<std::string> session_key(std::string const& account_name) const override
         {
-            static auto statement = database_.prepare_statement("SELECT session_key FROM user WHERE account_name = ?");
+            auto statement = database_.prepare_statement("SELECT session_key FROM user WHERE account_name = ?");
 
             statement.add_parameter(account_name);
 
@@ -95,10 +122,10 @@ namespace keycap::shared::database::dal
 
         void user_id_from_username(std::string const& username, user_id_callback callback) const override
         {
-            static auto statement = database_.prepare_statement("SELECT id FROM user WHERE account_name = ?");
+            auto statement = database_.prepare_statement("SELECT id FROM user WHERE account_name = ?");
             statement.add_parameter(username);
 
-            auto whenDone = [callback](std::unique_ptr<sql::ResultSet> result) {
+            auto whenDone = [callback](std::unique_ptr<result_set> result) {
                 if (!result || !result->next())
                     return callback(std::nullopt);
 
@@ -109,10 +136,22 @@ namespace keycap::shared::database::dal
         }
 
       private:
+        static shared::database::user from_result(result_set& result)
+        {
+            return shared::database::user{result.getUInt("id"),
+                                          result.getString("account_name").c_str(),
+                                          result.getString("email").c_str(),
+                                          static_cast<uint8>(result.getUInt("security_options")),
+                                          result.getUInt("flags"),
+                                          result.getString("verifier").c_str(),
+                                          result.getString("salt").c_str(),
+                                          result.getString("session_key").c_str()};
+        }
+
         database& database_;
     };
 
-    std::unique_ptr<user_dao> get_user_dao(database& database)
+    std::unique_ptr<user_dao> get_mysql_user_dao(database& database)
     {
         return std::make_unique<mysql_user_dao>(database);
     }
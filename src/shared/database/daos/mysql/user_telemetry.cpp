@@ -29,24 +29,37 @@ namespace keycap::shared::database::dal
         {
         }
 
-        void add_telemetry_data(std::string const& account_name, std::string const& data) override
+        void add_telemetry(std::vector<user_telemetry> entries, add_telemetry_callback callback) override
         {
-            static auto statement
-                = database_.prepare_statement("INSERT INTO user_telemetry (date_taken, telemetry, id) VALUES ( ?, ?, "
-                                              "(SELECT id FROM user WHERE account_name = ?));");
+            if (entries.empty())
+                return callback(true);
 
-            statement.add_parameter(time(nullptr));
-            statement.add_parameter(data);
-            statement.add_parameter(account_name);
+            std::string sql
+                = "INSERT IGNORE INTO user_telemetry (id, date_taken, telemetry, raw_size) VALUES (?, ?, ?, ?)";
+            for (size_t i = 1; i < entries.size(); ++i)
+                sql += ", (?, ?, ?, ?)";
+            sql += ";";
 
-            statement.execute_async();
+            auto statement = database_.prepare_statement(sql);
+            for (auto const& entry : entries)
+            {
+                statement.add_parameter(entry.id);
+                statement.add_parameter(entry.date_taken);
+                statement.add_parameter(entry.telemetry);
+                statement.add_parameter(entry.raw_size);
+            }
+
+            // Duplicates are ignored, so a chunk that didn't insert anything still succeeded
+            statement.update_async([callback = std::move(callback)](std::optional<uint64_t> affected_rows) {
+                callback(affected_rows.has_value());
+            });
         }
 
       private:
         database& database_;
     };
 
-    std::unique_ptr<user_telemetry_dao> get_user_telemetry_dao(database& database)
+    std::unique_ptr<user_telemetry_dao> get_mysql_user_telemetry_dao(database& database)
     {
         return std::make_unique<mysql_user_telemetry_dao>(database);
     }
@@ -14,6 +14,8 @@
     limitations under the License.
 */
 
+#pragma once
+
 #include "../../database.hpp"
 #include "../base/user_telemetry.hpp"
 
@@ -21,5 +23,5 @@
 
 namespace keycap::shared::database::dal
 {
-    std::unique_ptr<user_telemetry_dao> get_user_telemetry_dao(database& database);
+    std::unique_ptr<user_telemetry_dao> get_mysql_user_telemetry_dao(database& database);
 }
\ No newline at end of file
@@ -14,4 +14,19 @@
     limitations under the License.
 */
 
-#include "mysql/realm.hpp"
\ No newline at end of file
+#pragma once
+
+#include "memory/realm.hpp"
+#include "mysql/realm.hpp"
+
+namespace keycap::shared::database::dal
+{
+    // Returns the realm dao of the database's backend
+    inline std::unique_ptr<realm_dao> get_realm_dao(database& database)
+    {
+        if (database.backend() == database_backend::memory)
+            return get_memory_realm_dao(database);
+
+        return get_mysql_realm_dao(database);
+    }
+}
@@ -14,4 +14,19 @@
     limitations under the License.
 */
 
-#include "mysql/user.hpp"
\ No newline at end of file
+#pragma once
+
+#include "memory/user.hpp"
+#include "mysql/user.hpp"
+
+namespace keycap::shared::database::dal
+{
+    // Returns the user dao of the database's backend
+    inline std::unique_ptr<user_dao> get_user_dao(database& database)
+    {
+        if (database.backend() == database_backend::memory)
+            return get_memory_user_dao(database);
+
+        return get_mysql_user_dao(database);
+    }
+}
@@ -14,4 +14,19 @@
     limitations under the License.
 */
 
-#include "mysql/user_telemetry.hpp"
\ No newline at end of file
+#pragma once
+
+#include "memory/user_telemetry.hpp"
+#include "mysql/user_telemetry.hpp"
+
+namespace keycap::shared::database::dal
+{
+    // Returns the user_telemetry dao of the database's backend
+    inline std::unique_ptr<user_telemetry_dao> get_user_telemetry_dao(database& database)
+    {
+        if (database.backend() == database_backend::memory)
+            return get_memory_user_telemetry_dao(database);
+
+        return get_mysql_user_telemetry_dao(database);
+    }
+}
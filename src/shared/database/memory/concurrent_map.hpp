@@ -0,0 +1,142 @@
+/*
+    Copyright 2018-2019 KeycapEmu
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#pragma once
+
+#include <array>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <unordered_map>
+#include <utility>
+
+namespace keycap::shared::database::memory
+{
+    // A hash map split into independently locked shards. Readers of a shard share its lock, so lookups only contend
+    // with writes that hash to the same shard.
+    // Values are copied out instead of handing out references that could outlive the lock
+    template <typename KEY, typename VALUE, typename HASH = std::hash<KEY>>
+    class concurrent_map
+    {
+        static constexpr size_t shard_count = 32;
+
+        struct shard
+        {
+            mutable std::shared_mutex mutex;
+            std::unordered_map<KEY, VALUE, HASH> entries;
+        };
+
+      public:
+        // Inserts the given value if there is no value with the given key yet. Returns wether it was inserted
+        bool insert(KEY const& key, VALUE value)
+        {
+            auto& shard = shard_of(key);
+            std::unique_lock<std::shared_mutex> lock{shard.mutex};
+            return shard.entries.emplace(key, std::move(value)).second;
+        }
+
+        // Returns a copy of the value with the given key
+        std::optional<VALUE> find(KEY const& key) const
+        {
+            auto const& shard = shard_of(key);
+            std::shared_lock<std::shared_mutex> lock{shard.mutex};
+
+            auto itr = shard.entries.find(key);
+            if (itr == shard.entries.end())
+                return std::nullopt;
+
+            return itr->second;
+        }
+
+        bool contains(KEY const& key) const
+        {
+            auto const& shard = shard_of(key);
+            std::shared_lock<std::shared_mutex> lock{shard.mutex};
+            return shard.entries.count(key) != 0;
+        }
+
+        // Calls function(VALUE&) with the value of the given key while holding the shard exclusively.
+        // Returns false if there is no such value
+        template <typename FUNCTION>
+        bool update(KEY const& key, FUNCTION&& function)
+        {
+            auto& shard = shard_of(key);
+            std::unique_lock<std::shared_mutex> lock{shard.mutex};
+
+            auto itr = shard.entries.find(key);
+            if (itr == shard.entries.end())
+                return false;
+
+            function(itr->second);
+            return true;
+        }
+
+        // Like update() but default constructs the value first if there is none
+        template <typename FUNCTION>
+        void upsert(KEY const& key, FUNCTION&& function)
+        {
+            auto& shard = shard_of(key);
+            std::unique_lock<std::shared_mutex> lock{shard.mutex};
+            function(shard.entries[key]);
+        }
+
+        bool erase(KEY const& key)
+        {
+            auto& shard = shard_of(key);
+            std::unique_lock<std::shared_mutex> lock{shard.mutex};
+            return shard.entries.erase(key) != 0;
+        }
+
+        // Calls function(KEY const&, VALUE const&) for every entry. Shards are visited one after another, so this isn't
+        // a consistent snapshot of the whole map
+        template <typename FUNCTION>
+        void for_each(FUNCTION&& function) const
+        {
+            for (auto const& shard : shards_)
+            {
+                std::shared_lock<std::shared_mutex> lock{shard.mutex};
+                for (auto const& [key, value] : shard.entries)
+                    function(key, value);
+            }
+        }
+
+        size_t size() const
+        {
+            size_t size = 0;
+            for (auto const& shard : shards_)
+            {
+                std::shared_lock<std::shared_mutex> lock{shard.mutex};
+                size += shard.entries.size();
+            }
+
+            return size;
+        }
+
+      private:
+        shard& shard_of(KEY const& key)
+        {
+            return shards_[HASH{}(key) % shard_count];
+        }
+
+        shard const& shard_of(KEY const& key) const
+        {
+            return shards_[HASH{}(key) % shard_count];
+        }
+
+        std::array<shard, shard_count> shards_;
+    };
+}
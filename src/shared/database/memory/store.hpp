@@ -0,0 +1,60 @@
+/*
+    Copyright 2018-2019 KeycapEmu
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#pragma once
+
+#include "concurrent_map.hpp"
+
+#include <generated/character.hpp>
+#include <generated/ip_ban.hpp>
+#include <generated/knowledge_base.hpp>
+#include <generated/realm.hpp>
+#include <generated/user.hpp>
+#include <generated/user_telemetry.hpp>
+
+#include <keycap/root/types.hpp>
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+namespace keycap::shared::database::memory
+{
+    // The tables of the in-memory database backend
+    struct store
+    {
+        // Keyed by the upper case account name, just like MySQL's case insensitive collation would compare them
+        concurrent_map<std::string, user> users;
+        std::atomic_uint32_t next_user_id{1};
+
+        concurrent_map<uint32, character> characters;
+        std::atomic_uint32_t next_character_id{1};
+        // Keyed by character id
+        concurrent_map<uint32, realm_character> realm_characters;
+        // Keyed by "<realm>:<name>" to keep character names unique per realm
+        concurrent_map<std::string, uint32> character_names;
+
+        concurrent_map<uint8, realm> realms;
+        // Keyed by user id
+        concurrent_map<uint32, std::vector<user_telemetry>> telemetry;
+        concurrent_map<uint32, ip_ban> ip_bans;
+
+        concurrent_map<int32, category> categories;
+        // Keyed by category id
+        concurrent_map<int32, std::vector<sub_category>> sub_categories;
+        concurrent_map<int32, article> articles;
+    };
+}
@@ -0,0 +1,170 @@
+/*
+    Copyright 2018-2019 KeycapEmu
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "connection_pool.hpp"
+
+#include <cppconn/exception.h>
+
+#include <algorithm>
+
+namespace keycap::shared::database
+{
+    // Connections that haven't been used for this long are pinged before they are handed out
+    constexpr std::chrono::seconds health_check_interval{30};
+
+    connection_pool::lease::lease(connection_pool& pool, slot& slot, size_t index, std::unique_lock<std::mutex> lock)
+      : pool_{&pool}
+      , slot_{&slot}
+      , index_{index}
+      , lock_{std::move(lock)}
+      , acquired_{clock::now()}
+    {
+    }
+
+    connection_pool::lease::~lease()
+    {
+        if (!lock_.owns_lock())
+            return;
+
+        auto now = clock::now();
+        slot_->last_used = now;
+        slot_->busy_microseconds += std::chrono::duration_cast<std::chrono::microseconds>(now - acquired_).count();
+        ++slot_->executions;
+    }
+
+    sql::PreparedStatement& connection_pool::lease::prepare(std::string const& statement)
+    {
+        auto& prepared = slot_->statements[statement];
+        if (!prepared)
+            prepared.reset(slot_->connection->prepareStatement(statement.c_str()));
+
+        return *prepared;
+    }
+
+    void connection_pool::lease::reconnect()
+    {
+        ++slot_->reconnects;
+        pool_->open(*slot_);
+    }
+
+    void connection_pool::lease::fail()
+    {
+        ++slot_->failures;
+    }
+
+    connection_pool::connection_pool(sql::mysql::MySQL_Driver& driver)
+      : driver_{driver}
+      , created_{clock::now()}
+    {
+    }
+
+    void connection_pool::connect(connection_info const& info, size_t size)
+    {
+        info_ = info;
+        created_ = clock::now();
+
+        slots_.clear();
+        for (size_t i = 0; i < std::max<size_t>(size, 1); ++i)
+        {
+            auto& slot = slots_.emplace_back(std::make_unique<connection_pool::slot>());
+            open(*slot);
+        }
+    }
+
+    connection_pool::lease connection_pool::acquire()
+    {
+        auto start = next_++ % slots_.size();
+
+        // Prefer any idle connection and only queue up behind a busy one if there is none
+        for (size_t i = 0; i < slots_.size(); ++i)
+        {
+            auto index = (start + i) % slots_.size();
+            auto& slot = *slots_[index];
+
+            std::unique_lock<std::mutex> lock{slot.mutex, std::try_to_lock};
+            if (lock.owns_lock())
+            {
+                validate(slot);
+                return lease{*this, slot, index, std::move(lock)};
+            }
+        }
+
+        auto& slot = *slots_[start];
+        std::unique_lock<std::mutex> lock{slot.mutex};
+        validate(slot);
+        return lease{*this, slot, start, std::move(lock)};
+    }
+
+    bool connection_pool::is_connected() const
+    {
+        return std::any_of(slots_.begin(), slots_.end(), [](auto const& slot) { return slot->connected.load(); });
+    }
+
+    std::vector<connection_stats> connection_pool::stats() const
+    {
+        auto lifetime = std::chrono::duration_cast<std::chrono::microseconds>(clock::now() - created_).count();
+
+        std::vector<connection_stats> stats;
+        for (size_t i = 0; i < slots_.size(); ++i)
+        {
+            auto const& slot = *slots_[i];
+
+            connection_stats entry;
+            entry.index = i;
+            entry.connected = slot.connected;
+            entry.executions = slot.executions;
+            entry.failures = slot.failures;
+            entry.reconnects = slot.reconnects;
+            entry.utilization = lifetime > 0 ? static_cast<double>(slot.busy_microseconds) / lifetime : 0.0;
+
+            stats.emplace_back(entry);
+        }
+
+        return stats;
+    }
+
+    void connection_pool::open(slot& slot)
+    {
+        // Statements belong to the connection they were prepared on
+        slot.connected = false;
+        slot.statements.clear();
+        slot.connection.reset();
+
+        slot.connection.reset(driver_.connect(info_.host.c_str(), info_.username.c_str(), info_.password.c_str()));
+        slot.connection->setSchema(info_.schema.c_str());
+        slot.last_used = clock::now();
+        slot.connected = true;
+    }
+
+    void connection_pool::validate(slot& slot)
+    {
+        try
+        {
+            if (slot.connection && !slot.connection->isClosed()
+                && (clock::now() - slot.last_used < health_check_interval || slot.connection->isValid()))
+                return;
+
+            ++slot.reconnects;
+            open(slot);
+        }
+        catch (sql::SQLException const&)
+        {
+            // The next lease of this connection tries again
+            ++slot.failures;
+            throw;
+        }
+    }
+}
@@ -0,0 +1,151 @@
+/*
+    Copyright 2018-2019 KeycapEmu
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#pragma once
+
+#include <mysql_connection.h>
+#include <mysql_driver.h>
+
+#include <cppconn/prepared_statement.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace keycap::shared::database
+{
+    struct connection_info
+    {
+        std::string host;
+        uint16_t port = 3306;
+        std::string username;
+        std::string password;
+        std::string schema;
+    };
+
+    struct connection_stats
+    {
+        size_t index = 0;
+        bool connected = false;
+        uint64_t executions = 0;
+        uint64_t failures = 0;
+        uint64_t reconnects = 0;
+        // Share of the pool's lifetime the connection spent executing statements (0 - 1)
+        double utilization = 0.0;
+    };
+
+    // A fixed number of connections to the same database. Every connection is used by one thread at a time, so a pool
+    // sized to the number of database threads lets all of them run statements in parallel.
+    // Connections that were idle for a while are validated before they are handed out and can be reconnected by their
+    // current user whenever the server went away.
+    class connection_pool
+    {
+        using clock = std::chrono::steady_clock;
+
+        struct slot
+        {
+            std::mutex mutex;
+            std::unique_ptr<sql::Connection> connection;
+            // Every statement that has been prepared on this connection, keyed by its SQL text
+            std::unordered_map<std::string, std::unique_ptr<sql::PreparedStatement>> statements;
+            clock::time_point last_used;
+
+            std::atomic_bool connected{false};
+            std::atomic_uint64_t executions{0};
+            std::atomic_uint64_t failures{0};
+            std::atomic_uint64_t reconnects{0};
+            std::atomic_uint64_t busy_microseconds{0};
+        };
+
+      public:
+        // Exclusive access to one of the pool's connections until the lease is destroyed
+        class lease
+        {
+            friend class connection_pool;
+
+          public:
+            lease(lease&&) = default;
+            lease& operator=(lease&&) = default;
+            ~lease();
+
+            sql::Connection& connection() const
+            {
+                return *slot_->connection;
+            }
+
+            // Returns the index of the leased connection within the pool
+            size_t index() const
+            {
+                return index_;
+            }
+
+            // Returns the given statement prepared on the leased connection. Each SQL text is only prepared once per
+            // connection
+            sql::PreparedStatement& prepare(std::string const& statement);
+
+            // Replaces the leased connection with a new one. Throws if the database can't be reached
+            void reconnect();
+
+            // Marks the statement executed with this lease as failed
+            void fail();
+
+          private:
+            lease(connection_pool& pool, slot& slot, size_t index, std::unique_lock<std::mutex> lock);
+
+            connection_pool* pool_;
+            slot* slot_;
+            size_t index_;
+            std::unique_lock<std::mutex> lock_;
+            clock::time_point acquired_;
+        };
+
+        explicit connection_pool(sql::mysql::MySQL_Driver& driver);
+
+        // Opens `size` connections with the given connection information
+        void connect(connection_info const& info, size_t size);
+
+        // Returns a lease for an unused connection or waits for one if all of them are in use
+        lease acquire();
+
+        // Returns the number of connections
+        size_t size() const
+        {
+            return slots_.size();
+        }
+
+        // Returns wether at least one connection is open
+        bool is_connected() const;
+
+        std::vector<connection_stats> stats() const;
+
+      private:
+        void open(slot& slot);
+
+        // Reconnects the given slot if it's closed or didn't pass the health check. Throws if that fails
+        void validate(slot& slot);
+
+        sql::mysql::MySQL_Driver& driver_;
+        connection_info info_;
+        std::vector<std::unique_ptr<slot>> slots_;
+        std::atomic_size_t next_{0};
+        clock::time_point created_;
+    };
+}
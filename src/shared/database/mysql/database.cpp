@@ -22,29 +22,43 @@ namespace keycap::shared::database
     database::database(boost::asio::io_service& work_service)
       : work_service_(work_service)
       , driver_(sql::mysql::get_driver_instance())
+      , pool_(*driver_)
     {
     }
 
     void database::connect(std::string const& host, uint16_t port, std::string const& username,
-                           std::string const& password, std::string const& schema)
+                           std::string const& password, std::string const& schema, size_t connections)
     {
-        connection_.reset(driver_->connect(host.c_str(), username.c_str(), password.c_str()));
-        connection_->setSchema(schema.c_str());
+        pool_.connect(connection_info{host, port, username, password, schema}, connections);
+    }
+
+    void database::open_memory()
+    {
+        backend_ = database_backend::memory;
     }
 
     prepared_statement database::prepare_statement(std::string const& statement)
     {
-        return prepared_statement(connection_->prepareStatement(statement.c_str()), work_service_);
+        return prepared_statement(statement, *this);
+    }
+
+    transaction database::begin_transaction()
+    {
+        return transaction{*this};
     }
 
     bool database::is_connected() const
     {
-        return connection_ != nullptr && !connection_->isClosed();
+        if (backend_ == database_backend::memory)
+            return true;
+
+        return pool_.is_connected();
     }
 
-    bool database::execute(std::string const& statement) const
+    bool database::execute(std::string const& statement)
     {
-        std::unique_ptr<sql::Statement> stmt{connection_->createStatement()};
+        auto lease = pool_.acquire();
+        std::unique_ptr<sql::Statement> stmt{lease.connection().createStatement()};
 
         return stmt->execute(statement.c_str());
     }
@@ -16,37 +16,85 @@
 
 #pragma once
 
+#include "connection_pool.hpp"
+#include "transaction.hpp"
+#include "../memory/store.hpp"
+
 #include <boost/asio.hpp>
 
 #include <mysql_connection.h>
 #include <mysql_driver.h>
 
 #include <string>
+#include <vector>
 
 namespace keycap::shared::database
 {
     class prepared_statement;
 
+    enum class database_backend
+    {
+        mysql,
+        // Keeps all data in the process. Meant for benchmarks and runs without a MySQL server
+        memory,
+    };
+
     class database
     {
       public:
         explicit database(boost::asio::io_service& work_service);
 
-        // Connects to the database with the given connection information
+        // Connects to the database with the given connection information. Opens one connection per database thread so
+        // the statements they execute don't have to wait for each other
         void connect(std::string const& host, uint16_t port, std::string const& username, std::string const& password,
-                     std::string const& schema);
+                     std::string const& schema, size_t connections = 1);
 
         // Prepares the given statement
         prepared_statement prepare_statement(std::string const& statement);
 
+        // Starts a transaction. Its statements are collected until it's committed
+        transaction begin_transaction();
+
+        // Switches to the in-memory backend. DAOs obtained afterwards never touch MySQL
+        void open_memory();
+
+        database_backend backend() const
+        {
+            return backend_;
+        }
+
+        // Returns the tables of the in-memory backend
+        memory::store& memory_store()
+        {
+            return memory_store_;
+        }
+
+        // Returns the io_service the database threads run
+        boost::asio::io_service& work_service()
+        {
+            return work_service_;
+        }
+
         // Returns wether the database is connected
         bool is_connected() const;
 
-        bool execute(std::string const& statement) const;
+        bool execute(std::string const& statement);
+
+        // Returns the utilization and error counters of every pooled connection
+        std::vector<connection_stats> stats() const
+        {
+            return pool_.stats();
+        }
 
       private:
+        friend class prepared_statement;
+        friend class transaction;
+
         boost::asio::io_service& work_service_;
         std::unique_ptr<sql::mysql::MySQL_Driver> driver_;
-        std::unique_ptr<sql::Connection> connection_;
+        connection_pool pool_;
+
+        database_backend backend_ = database_backend::mysql;
+        memory::store memory_store_;
     };
 }
\ No newline at end of file
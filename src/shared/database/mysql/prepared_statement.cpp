@@ -15,90 +15,167 @@
 */
 
 #include "prepared_statement.hpp"
+#include "database.hpp"
 
 #include <mysql_connection.h>
 #include <mysql_driver.h>
 
+#include <cppconn/exception.h>
 #include <cppconn/prepared_statement.h>
+#include <cppconn/resultset.h>
+
+#include <type_traits>
 
 namespace keycap::shared::database
 {
-    prepared_statement::prepared_statement(sql::PreparedStatement* statement, boost::asio::io_service& work_service)
-      : statement_(statement)
-      , work_service_(work_service)
+    prepared_statement::prepared_statement(std::string statement, database& database)
+      : sql_{std::move(statement)}
+      , pool_{database.pool_}
+      , work_service_{database.work_service_}
     {
     }
 
     void prepared_statement::execute_async()
     {
-        parameter_index_ = 1;
-        work_service_.post([&] {
+        work_service_.post([&pool = pool_, statement = sql_, parameters = take_parameters()] {
+            try
+            {
+                execute(pool, statement, parameters);
+            }
+            catch (...)
+            {
+            }
+        });
+    }
+
+    void prepared_statement::update_async(update_async_callback callback)
+    {
+        work_service_.post([&pool = pool_, statement = sql_, parameters = take_parameters(),
+                            callback = std::move(callback)] {
+            std::optional<uint64_t> affected_rows;
             try
             {
-                execute();
+                affected_rows = update(pool, statement, parameters);
             }
             catch (...)
             {
             }
+
+            callback(affected_rows);
         });
     }
 
     bool prepared_statement::execute()
     {
-        parameter_index_ = 1;
-        return statement_->executeUpdate() != 0;
+        return execute(pool_, sql_, take_parameters());
+    }
+
+    std::unique_ptr<result_set> prepared_statement::query()
+    {
+        return query(pool_, sql_, take_parameters());
+    }
+
+    bool prepared_statement::execute(connection_pool& pool, std::string const& statement,
+                                     parameter_list const& parameters)
+    {
+        return with_connection(pool, [&](connection_pool::lease& lease) {
+            return bind(lease, statement, parameters).executeUpdate() != 0;
+        });
+    }
+
+    uint64_t prepared_statement::update(connection_pool& pool, std::string const& statement,
+                                        parameter_list const& parameters)
+    {
+        return with_connection(pool, [&](connection_pool::lease& lease) {
+            return static_cast<uint64_t>(bind(lease, statement, parameters).executeUpdate());
+        });
+    }
+
+    std::unique_ptr<result_set> prepared_statement::query(connection_pool& pool, std::string const& statement,
+                                                          parameter_list const& parameters)
+    {
+        // The rows are read before the lease is released, the cached statement they belong to is reused afterwards
+        return with_connection(pool, [&](connection_pool::lease& lease) {
+            std::unique_ptr<sql::ResultSet> result{bind(lease, statement, parameters).executeQuery()};
+            return std::make_unique<result_set>(*result);
+        });
     }
 
-    std::unique_ptr<sql::ResultSet> prepared_statement::query()
+    sql::PreparedStatement& prepared_statement::bind(connection_pool::lease& lease, std::string const& sql,
+                                                     parameter_list const& parameters)
     {
-        parameter_index_ = 1;
-        return std::unique_ptr<sql::ResultSet>(statement_->executeQuery());
+        auto& statement = lease.prepare(sql);
+        for (size_t i = 0; i < parameters.size(); ++i)
+        {
+            auto index = static_cast<unsigned int>(i + 1);
+            std::visit(
+                [&](auto const& value) {
+                    using T = std::decay_t<decltype(value)>;
+
+                    // Passes the length along so binary data survives embedded zero bytes
+                    if constexpr (std::is_same_v<T, std::string>)
+                        statement.setString(index, sql::SQLString{value.data(), value.size()});
+                    else if constexpr (std::is_same_v<T, int>)
+                        statement.setInt(index, value);
+                    else if constexpr (std::is_same_v<T, uint8_t> || std::is_same_v<T, uint32_t>)
+                        statement.setUInt(index, value);
+                    else if constexpr (std::is_same_v<T, uint64_t>)
+                        statement.setUInt64(index, value);
+                    else if constexpr (std::is_same_v<T, int64_t>)
+                        statement.setInt64(index, value);
+                    else if constexpr (std::is_same_v<T, float>)
+                        statement.setDouble(index, value);
+                },
+                parameters[i]);
+        }
+
+        return statement;
     }
 
     void prepared_statement::add_parameter(std::string const& parameter)
     {
-        statement_->setString(parameter_index_++, parameter.c_str());
+        parameters_.emplace_back(std::in_place_type<std::string>, parameter);
     }
 
     template <>
     void prepared_statement::add_parameter(int param)
     {
-        statement_->setInt(parameter_index_++, param);
+        parameters_.emplace_back(std::in_place_type<int>, param);
     }
 
     template <>
     void prepared_statement::add_parameter(uint8_t param)
     {
-        statement_->setUInt(parameter_index_++, param);
+        parameters_.emplace_back(std::in_place_type<uint8_t>, param);
     }
 
     template <>
     void prepared_statement::add_parameter(uint32_t param)
     {
-        statement_->setUInt(parameter_index_++, param);
+        parameters_.emplace_back(std::in_place_type<uint32_t>, param);
     }
 
     template <>
     void prepared_statement::add_parameter(uint64_t param)
     {
-        statement_->setUInt64(parameter_index_++, param);
+        parameters_.emplace_back(std::in_place_type<uint64_t>, param);
     }
 
     template <>
     void prepared_statement::add_parameter(int64_t param)
     {
-        statement_->setInt64(parameter_index_++, param);
+        parameters_.emplace_back(std::in_place_type<int64_t>, param);
     }
 
     template <>
     void prepared_statement::add_parameter(const char* param)
     {
-        statement_->setString(parameter_index_++, param);
+        parameters_.emplace_back(std::in_place_type<std::string>, param);
     }
 
     template <>
     void prepared_statement::add_parameter(float param)
     {
-        statement_->setDouble(parameter_index_++, param);
+        parameters_.emplace_back(std::in_place_type<float>, param);
     }
 }
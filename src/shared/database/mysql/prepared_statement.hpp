@@ -16,20 +16,40 @@
 
 #pragma once
 
+#include "connection_pool.hpp"
+#include "result_set.hpp"
+
 #include <boost/asio.hpp>
 
+#include <cppconn/exception.h>
 #include <cppconn/prepared_statement.h>
 
+#include <cstdint>
 #include <memory>
+#include <optional>
 #include <string>
+#include <utility>
+#include <variant>
+#include <vector>
 
 namespace keycap::shared::database
 {
     class database;
 
+    // MySQL client errors for a connection that was closed by the server or lost on the way
+    constexpr int server_gone_error = 2006;
+    constexpr int server_lost_error = 2013;
+
+    // A statement and its parameters. It's cheap to create and meant to be created for every execution.
+    // Parameters are collected on the calling thread and copied into the job that binds them on the database thread.
+    // The statement itself is only prepared once per pooled connection
     class prepared_statement
     {
         friend class database;
+        friend class transaction;
+
+        using parameter = std::variant<std::string, int, uint8_t, uint32_t, uint64_t, int64_t, float>;
+        using parameter_list = std::vector<parameter>;
 
       public:
         // Adds the given parameter to the parameter list
@@ -45,11 +65,11 @@ namespace keycap::shared::database
         // Callback must have the signature callback(bool success)
         void execute_async(execute_async_callback callback)
         {
-            parameter_index_ = 1;
-            work_service_.post([&, callback = std::move(callback)] {
+            work_service_.post([&pool = pool_, statement = sql_, parameters = take_parameters(),
+                                callback = std::move(callback)] {
                 try
                 {
-                    auto success = execute();
+                    auto success = execute(pool, statement, parameters);
                     callback(success);
                 }
                 catch (std::exception const& e)
@@ -66,21 +86,30 @@ namespace keycap::shared::database
 
         void execute_async();
 
+        using update_async_callback = std::function<void(std::optional<uint64_t>)>;
+
+        // Executes the statement asynchronously and calls the given callback from the database thread with the number
+        // of affected rows. Unlike execute_async, a statement that didn't change anything, like an INSERT IGNORE of
+        // duplicates only, is not a failure.
+        // Callback must have the signature callback(std::optional<uint64_t> affected_rows) and receives std::nullopt
+        // if the statement failed
+        void update_async(update_async_callback callback);
+
         // Executes the statement synchronously and returns wether it succeeded
         bool execute();
 
-        using query_async_callback = std::function<void(std::unique_ptr<sql::ResultSet>)>;
+        using query_async_callback = std::function<void(std::unique_ptr<result_set>)>;
 
         // Queries the database asynchronously and calls the given callback from the database thread.
-        // Callback must have the signature callback(std::unique_ptr<sql::ResultSet> result_set)
+        // Callback must have the signature callback(std::unique_ptr<result_set> result_set) and receives nullptr if
+        // the query failed
         void query_async(query_async_callback callback)
         {
-            parameter_index_ = 1;
-
-            work_service_.post([&, callback = std::move(callback)] {
+            work_service_.post([&pool = pool_, statement = sql_, parameters = take_parameters(),
+                                callback = std::move(callback)] {
                 try
                 {
-                    auto result = query();
+                    auto result = query(pool, statement, parameters);
                     callback(std::move(result));
                 }
                 catch (...)
@@ -91,14 +120,63 @@ namespace keycap::shared::database
         }
 
         // Queries the database synchronously and returns the result set
-        std::unique_ptr<sql::ResultSet> query();
+        std::unique_ptr<result_set> query();
 
       private:
-        prepared_statement(sql::PreparedStatement* statement, boost::asio::io_service& work_service);
+        prepared_statement(std::string statement, database& database);
+
+        parameter_list take_parameters()
+        {
+            return std::exchange(parameters_, parameter_list{});
+        }
+
+        static bool execute(connection_pool& pool, std::string const& statement, parameter_list const& parameters);
+        static uint64_t update(connection_pool& pool, std::string const& statement, parameter_list const& parameters);
+        static std::unique_ptr<result_set> query(connection_pool& pool, std::string const& statement,
+                                                 parameter_list const& parameters);
+
+        // Returns the given statement prepared on the leased connection with the given parameters bound to it
+        static sql::PreparedStatement& bind(connection_pool::lease& lease, std::string const& statement,
+                                            parameter_list const& parameters);
+
+        // Runs the given function with a leased connection and retries it once on a new connection if the server
+        // went away in the meantime
+        template <typename FUNCTION>
+        static auto with_connection(connection_pool& pool, FUNCTION&& function);
 
-        std::unique_ptr<sql::PreparedStatement> statement_;
+        std::string sql_;
+        connection_pool& pool_;
         boost::asio::io_service& work_service_;
 
-        int parameter_index_ = 1;
+        parameter_list parameters_;
     };
+
+    template <typename FUNCTION>
+    auto prepared_statement::with_connection(connection_pool& pool, FUNCTION&& function)
+    {
+        auto lease = pool.acquire();
+        try
+        {
+            return function(lease);
+        }
+        catch (sql::SQLException const& e)
+        {
+            if (e.getErrorCode() != server_gone_error && e.getErrorCode() != server_lost_error)
+            {
+                lease.fail();
+                throw;
+            }
+        }
+
+        try
+        {
+            lease.reconnect();
+            return function(lease);
+        }
+        catch (...)
+        {
+            lease.fail();
+            throw;
+        }
+    }
 }
\ No newline at end of file
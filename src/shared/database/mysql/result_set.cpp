@@ -0,0 +1,110 @@
+/*
+    Copyright 2018-2019 KeycapEmu
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "result_set.hpp"
+
+#include <cppconn/resultset.h>
+#include <cppconn/resultset_metadata.h>
+
+#include <stdexcept>
+
+namespace keycap::shared::database
+{
+    result_set::result_set(sql::ResultSet& result)
+    {
+        auto metadata = result.getMetaData();
+        auto count = metadata->getColumnCount();
+
+        for (unsigned int i = 1; i <= count; ++i)
+            columns_.emplace(metadata->getColumnLabel(i).asStdString(), i - 1);
+
+        while (result.next())
+        {
+            auto& row = rows_.emplace_back(count);
+            for (unsigned int i = 1; i <= count; ++i)
+            {
+                if (!result.isNull(i))
+                    row[i - 1] = result.getString(i).asStdString();
+            }
+        }
+    }
+
+    bool result_set::next()
+    {
+        if (position_ >= rows_.size())
+            return false;
+
+        ++position_;
+        return true;
+    }
+
+    bool result_set::isNull(std::string const& column) const
+    {
+        return !value(column);
+    }
+
+    std::string result_set::getString(std::string const& column) const
+    {
+        return value(column).value_or(std::string{});
+    }
+
+    int32_t result_set::getInt(std::string const& column) const
+    {
+        auto const& data = value(column);
+        return data ? static_cast<int32_t>(std::stol(*data)) : 0;
+    }
+
+    uint32_t result_set::getUInt(std::string const& column) const
+    {
+        auto const& data = value(column);
+        return data ? static_cast<uint32_t>(std::stoul(*data)) : 0;
+    }
+
+    int64_t result_set::getInt64(std::string const& column) const
+    {
+        auto const& data = value(column);
+        return data ? std::stoll(*data) : 0;
+    }
+
+    uint64_t result_set::getUInt64(std::string const& column) const
+    {
+        auto const& data = value(column);
+        return data ? std::stoull(*data) : 0;
+    }
+
+    double result_set::getDouble(std::string const& column) const
+    {
+        auto const& data = value(column);
+        return data ? std::stod(*data) : 0.0;
+    }
+
+    bool result_set::getBoolean(std::string const& column) const
+    {
+        return getInt64(column) != 0;
+    }
+
+    std::optional<std::string> const& result_set::value(std::string const& column) const
+    {
+        if (position_ == 0 || position_ > rows_.size())
+            throw std::out_of_range{"result_set isn't positioned on a row"};
+
+        auto itr = columns_.find(column);
+        if (itr == columns_.end())
+            throw std::invalid_argument{"Unknown column " + column};
+
+        return rows_[position_ - 1][itr->second];
+    }
+}
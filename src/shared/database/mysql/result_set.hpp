@@ -0,0 +1,63 @@
+/*
+    Copyright 2018-2019 KeycapEmu
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace sql
+{
+    class ResultSet;
+}
+
+namespace keycap::shared::database
+{
+    // The rows of a query, read into memory while its connection was still leased. The statement that produced them
+    // is cached on that connection and may be executed again by another thread as soon as the lease is released.
+    // Offers the part of sql::ResultSet the DAOs use. Columns are addressed by their label
+    class result_set
+    {
+      public:
+        explicit result_set(sql::ResultSet& result);
+
+        // Moves to the next row. Must be called before reading the first one
+        bool next();
+
+        bool isNull(std::string const& column) const;
+
+        std::string getString(std::string const& column) const;
+        int32_t getInt(std::string const& column) const;
+        uint32_t getUInt(std::string const& column) const;
+        int64_t getInt64(std::string const& column) const;
+        uint64_t getUInt64(std::string const& column) const;
+        double getDouble(std::string const& column) const;
+        bool getBoolean(std::string const& column) const;
+
+      private:
+        // Returns the value of the given column in the current row. Throws if there is no such column
+        std::optional<std::string> const& value(std::string const& column) const;
+
+        std::unordered_map<std::string, size_t> columns_;
+        std::vector<std::vector<std::optional<std::string>>> rows_;
+        // Index of the current row plus one, 0 before next() has been called
+        size_t position_ = 0;
+    };
+}
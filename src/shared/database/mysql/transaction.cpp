@@ -0,0 +1,133 @@
+/*
+    Copyright 2018-2019 KeycapEmu
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "transaction.hpp"
+#include "database.hpp"
+
+#include <mysql_connection.h>
+
+#include <cppconn/exception.h>
+
+#include <keycap/root/utility/scope_exit.hpp>
+
+#include <utility>
+
+namespace keycap::shared::database
+{
+    transaction::transaction(database& database)
+      : pool_{database.pool_}
+      , work_service_{database.work_service_}
+    {
+    }
+
+    void transaction::add(prepared_statement statement)
+    {
+        statements_.emplace_back(transaction::statement{statement.sql_, statement.take_parameters()});
+    }
+
+    void transaction::commit_async(commit_callback callback)
+    {
+        work_service_.post([&pool = pool_, statements = std::exchange(statements_, {}),
+                            callback = std::move(callback)] {
+            try
+            {
+                callback(run(pool, statements));
+            }
+            catch (sql::SQLException const& e)
+            {
+                callback(e.getErrorCode());
+            }
+            catch (...)
+            {
+                callback(unknown_error);
+            }
+        });
+    }
+
+    int transaction::commit()
+    {
+        try
+        {
+            return run(pool_, std::exchange(statements_, {}));
+        }
+        catch (sql::SQLException const& e)
+        {
+            return e.getErrorCode();
+        }
+        catch (...)
+        {
+            return unknown_error;
+        }
+    }
+
+    int transaction::run(connection_pool& pool, std::vector<statement> const& statements)
+    {
+        return prepared_statement::with_connection(pool, [&](connection_pool::lease& lease) {
+            auto& connection = lease.connection();
+            connection.setAutoCommit(false);
+
+            // The connection goes back into the pool, so autocommit has to be restored however we leave
+            SCOPE_EXIT(sc, [&connection] {
+                try
+                {
+                    connection.setAutoCommit(true);
+                }
+                catch (...)
+                {
+                }
+            });
+
+            auto rollback = [&] {
+                lease.fail();
+                try
+                {
+                    connection.rollback();
+                }
+                catch (...)
+                {
+                }
+            };
+
+            bool committing = false;
+            try
+            {
+                for (auto const& [sql, parameters] : statements)
+                    prepared_statement::bind(lease, sql, parameters).executeUpdate();
+
+                committing = true;
+                connection.commit();
+            }
+            catch (sql::SQLException const& e)
+            {
+                // Nothing to roll back on a connection that went away, so with_connection retries the whole
+                // transaction. Unless it went away during the commit, which might have been applied already
+                auto lost = e.getErrorCode() == server_gone_error || e.getErrorCode() == server_lost_error;
+                if (lost && !committing)
+                    throw;
+
+                rollback();
+                return e.getErrorCode();
+            }
+            catch (...)
+            {
+                rollback();
+                throw;
+            }
+
+            return 0;
+        });
+    }
+}
@@ -0,0 +1,71 @@
+/*
+    Copyright 2018-2019 KeycapEmu
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#pragma once
+
+#include "prepared_statement.hpp"
+
+#include <boost/asio.hpp>
+
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace keycap::shared::database
+{
+    class database;
+
+    // Statements that are executed on one pooled connection and committed as a whole.
+    // Nothing is sent before commit. All statements then run in a single job on a database thread and are rolled back
+    // together if one of them fails. A transaction is only retried if its connection was lost before the commit had
+    // been sent. Otherwise it's unknown whether it has been applied, so the error is returned instead
+    class transaction
+    {
+        friend class database;
+
+      public:
+        // Returned instead of a MySQL error code if the transaction failed for another reason
+        static constexpr int unknown_error = -1;
+
+        // Adds the given statement with all parameters that have been added to it
+        void add(prepared_statement statement);
+
+        using commit_callback = std::function<void(int error)>;
+
+        // Commits the transaction asynchronously and calls the given callback from the database thread.
+        // error is 0 if the transaction has been committed, otherwise the MySQL error code of the failed statement
+        void commit_async(commit_callback callback);
+
+        // Commits the transaction synchronously and returns 0 or the MySQL error code of the failed statement
+        int commit();
+
+      private:
+        struct statement
+        {
+            std::string sql;
+            prepared_statement::parameter_list parameters;
+        };
+
+        explicit transaction(database& database);
+
+        static int run(connection_pool& pool, std::vector<statement> const& statements);
+
+        connection_pool& pool_;
+        boost::asio::io_service& work_service_;
+
+        std::vector<statement> statements_;
+    };
+}
@@ -1,6 +1,15 @@
 module keycap.shared.character;
 
-[keys="realm, `character`"][foreign_key="realm"]
+data id_block
+{
+    [primary] [not_null] [mysql_type="VARCHAR(32)"]
+    string name;
+
+    [not_null]
+    uint32 next_id;
+}
+
+[keys="realm, `character`"][unique="realm, name"][foreign_key="realm"]
 data realm_character
 {
     [not_null][foreign_key="realm(id)"][on_update="CASCADE"][on_delete="CASCADE"]
@@ -11,6 +20,9 @@ data realm_character
     
     [not_null][foreign_key="user(id)"][on_update="CASCADE"][on_delete="CASCADE"]
     uint32 account;
+
+    [not_null][mysql_type="VARCHAR(32)"]
+    string name;
 }
 
 data character_item
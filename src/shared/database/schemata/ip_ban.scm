@@ -0,0 +1,14 @@
+module keycap.shared.ip_ban;
+
+data ip_ban
+{
+    [primary] [not_null] [increment]
+    uint32 id;
+    [not_null]
+    string network;
+    [not_null]
+    uint8 allow;
+    string reason;
+    [not_null]
+    uint64 unban_date;
+}
\ No newline at end of file
@@ -7,6 +7,8 @@ data user_telemetry
     uint32 id;
     [not_null]
     uint64 date_taken;
-    [not_null]
+    [not_null][mysql_type="MEDIUMBLOB"]
     string telemetry;
+    [not_null]
+    uint32 raw_size;
 }
\ No newline at end of file
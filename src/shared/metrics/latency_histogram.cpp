@@ -0,0 +1,130 @@
+/*
+    Copyright 2018-2019 KeycapEmu
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "latency_histogram.hpp"
+
+#include <spdlog/fmt/fmt.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace keycap::shared::metrics
+{
+    size_t latency_histogram::index_of(uint64_t value)
+    {
+        if (value < 2 * sub_bucket_count)
+            return static_cast<size_t>(value);
+
+        uint64_t magnitude = 63;
+        while (!(value & (uint64_t{1} << magnitude)))
+            --magnitude;
+
+        auto shift = magnitude - sub_bucket_bits;
+        return static_cast<size_t>(shift * sub_bucket_count + (value >> shift));
+    }
+
+    uint64_t latency_histogram::highest_value_of(size_t index)
+    {
+        if (index < 2 * sub_bucket_count)
+            return index;
+
+        auto shift = index / sub_bucket_count - 1;
+        auto sub_bucket = index % sub_bucket_count + sub_bucket_count;
+        return ((sub_bucket + 1) << shift) - 1;
+    }
+
+    void latency_histogram::record(uint64_t microseconds)
+    {
+        buckets_[std::min(index_of(microseconds), bucket_count - 1)].fetch_add(1, std::memory_order_relaxed);
+        count_.fetch_add(1, std::memory_order_relaxed);
+        sum_.fetch_add(microseconds, std::memory_order_relaxed);
+
+        auto current = max_.load(std::memory_order_relaxed);
+        while (current < microseconds && !max_.compare_exchange_weak(current, microseconds, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    void latency_histogram::merge(latency_histogram const& other)
+    {
+        for (size_t i = 0; i < bucket_count; ++i)
+        {
+            if (auto value = other.buckets_[i].load(std::memory_order_relaxed); value)
+                buckets_[i].fetch_add(value, std::memory_order_relaxed);
+        }
+
+        count_.fetch_add(other.count(), std::memory_order_relaxed);
+        sum_.fetch_add(other.sum_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+
+        auto other_max = other.max();
+        auto current = max_.load(std::memory_order_relaxed);
+        while (current < other_max && !max_.compare_exchange_weak(current, other_max, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    void latency_histogram::reset()
+    {
+        for (auto& bucket : buckets_)
+            bucket.store(0, std::memory_order_relaxed);
+
+        count_.store(0, std::memory_order_relaxed);
+        sum_.store(0, std::memory_order_relaxed);
+        max_.store(0, std::memory_order_relaxed);
+    }
+
+    uint64_t latency_histogram::count() const
+    {
+        return count_.load(std::memory_order_relaxed);
+    }
+
+    uint64_t latency_histogram::max() const
+    {
+        return max_.load(std::memory_order_relaxed);
+    }
+
+    double latency_histogram::mean() const
+    {
+        auto n = count();
+        return n ? static_cast<double>(sum_.load(std::memory_order_relaxed)) / n : 0.0;
+    }
+
+    uint64_t latency_histogram::percentile(double percentile) const
+    {
+        auto total = count();
+        if (total == 0)
+            return 0;
+
+        auto wanted = static_cast<uint64_t>(std::ceil(total * std::clamp(percentile, 0.0, 100.0) / 100.0));
+        wanted = std::max<uint64_t>(wanted, 1);
+
+        uint64_t seen = 0;
+        for (size_t i = 0; i < bucket_count; ++i)
+        {
+            seen += buckets_[i].load(std::memory_order_relaxed);
+            if (seen >= wanted)
+                return std::min(highest_value_of(i), max());
+        }
+
+        return max();
+    }
+
+    std::string latency_histogram::summary() const
+    {
+        return fmt::format("n={} mean={:.0f}us p50={}us p99={}us p999={}us max={}us", count(), mean(),
+                           percentile(50.0), percentile(99.0), percentile(99.9), max());
+    }
+}
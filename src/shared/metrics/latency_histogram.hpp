@@ -0,0 +1,81 @@
+/*
+    Copyright 2018-2019 KeycapEmu
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace keycap::shared::metrics
+{
+    // A log-linear (HDR style) histogram of latencies in microseconds.
+    // Every power of two is split into 16 linear sub buckets which keeps the relative error below ~6%.
+    // Recording is lock-free and may happen from any number of threads.
+    class latency_histogram
+    {
+        static constexpr uint64_t sub_bucket_bits = 4;
+        static constexpr uint64_t sub_bucket_count = 1 << sub_bucket_bits;
+        static constexpr size_t bucket_count = (64 - sub_bucket_bits + 1) * sub_bucket_count;
+
+      public:
+        latency_histogram() = default;
+        latency_histogram(latency_histogram const&) = delete;
+        latency_histogram& operator=(latency_histogram const&) = delete;
+
+        // Records the given value in microseconds
+        void record(uint64_t microseconds);
+
+        // Records the given duration
+        template <typename REP, typename PERIOD>
+        void record(std::chrono::duration<REP, PERIOD> duration)
+        {
+            record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(duration).count()));
+        }
+
+        // Adds all values recorded by the given histogram to this one
+        void merge(latency_histogram const& other);
+
+        // Removes all recorded values
+        void reset();
+
+        // Returns the number of recorded values
+        uint64_t count() const;
+
+        // Returns the highest recorded value
+        uint64_t max() const;
+
+        // Returns the mean of all recorded values
+        double mean() const;
+
+        // Returns the value below which the given percentile (0 - 100) of all recorded values fall
+        uint64_t percentile(double percentile) const;
+
+        // Returns a one-line summary like "n=100 mean=12us p50=10us p99=40us p999=55us max=60us"
+        std::string summary() const;
+
+      private:
+        static size_t index_of(uint64_t value);
+        static uint64_t highest_value_of(size_t index);
+
+        std::array<std::atomic_uint64_t, bucket_count> buckets_{};
+        std::atomic_uint64_t count_{0};
+        std::atomic_uint64_t sum_{0};
+        std::atomic_uint64_t max_{0};
+    };
+}
@@ -0,0 +1,69 @@
+/*
+    Copyright 2018-2019 KeycapEmu
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "per_thread_histogram.hpp"
+
+#include <atomic>
+#include <unordered_map>
+
+namespace keycap::shared::metrics
+{
+    // Histograms are identified by id instead of address so a new histogram at a reused address won't pick up a
+    // dangling shard
+    std::atomic_uint64_t next_histogram_id{0};
+
+    per_thread_histogram::per_thread_histogram()
+      : id_{++next_histogram_id}
+    {
+    }
+
+    void per_thread_histogram::merge_into(latency_histogram& histogram) const
+    {
+        std::lock_guard<std::mutex> lock{mutex_};
+
+        for (auto const& shard : shards_)
+            histogram.merge(*shard);
+    }
+
+    void per_thread_histogram::reset()
+    {
+        std::lock_guard<std::mutex> lock{mutex_};
+
+        for (auto& shard : shards_)
+            shard->reset();
+    }
+
+    std::string per_thread_histogram::summary() const
+    {
+        latency_histogram merged;
+        merge_into(merged);
+        return merged.summary();
+    }
+
+    latency_histogram& per_thread_histogram::local()
+    {
+        thread_local std::unordered_map<uint64_t, latency_histogram*> shards;
+
+        if (auto shard = shards.find(id_); shard != shards.end())
+            return *shard->second;
+
+        std::lock_guard<std::mutex> lock{mutex_};
+
+        auto& shard = shards_.emplace_back(std::make_unique<latency_histogram>());
+        shards.emplace(id_, shard.get());
+        return *shard;
+    }
+}
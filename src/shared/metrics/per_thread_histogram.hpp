@@ -0,0 +1,70 @@
+/*
+    Copyright 2018-2019 KeycapEmu
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#pragma once
+
+#include "latency_histogram.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace keycap::shared::metrics
+{
+    // A latency_histogram that is split into one shard per recording thread so threads never contend on the same
+    // buckets. Reading merges all shards. Must outlive all threads that record into it
+    class per_thread_histogram
+    {
+      public:
+        per_thread_histogram();
+        per_thread_histogram(per_thread_histogram const&) = delete;
+        per_thread_histogram& operator=(per_thread_histogram const&) = delete;
+
+        // Records the given value in microseconds
+        void record(uint64_t microseconds)
+        {
+            local().record(microseconds);
+        }
+
+        // Records the given duration
+        template <typename REP, typename PERIOD>
+        void record(std::chrono::duration<REP, PERIOD> duration)
+        {
+            local().record(duration);
+        }
+
+        // Adds the values recorded by all threads to the given histogram
+        void merge_into(latency_histogram& histogram) const;
+
+        // Removes all recorded values
+        void reset();
+
+        // Returns latency_histogram::summary() of the values recorded by all threads
+        std::string summary() const;
+
+      private:
+        // Returns the calling thread's shard
+        latency_histogram& local();
+
+        uint64_t id_;
+
+        mutable std::mutex mutex_;
+        std::vector<std::unique_ptr<latency_histogram>> shards_;
+    };
+}
@@ -0,0 +1,176 @@
+/*
+    Copyright 2018-2019 KeycapEmu
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "account_service_ring.hpp"
+#include "services.hpp"
+#include "../string_utility.hpp"
+
+#include <keycap/root/utility/string.hpp>
+
+#include <algorithm>
+
+namespace net = keycap::root::network;
+
+namespace keycap::shared::network
+{
+    // FNV-1a. Must be stable across processes and platforms as every service has to route a key to the same node
+    uint64 ring_hash(void const* data, size_t size)
+    {
+        constexpr uint64 offset_basis = 14695981039346656037ull;
+        constexpr uint64 prime = 1099511628211ull;
+
+        auto bytes = static_cast<uint8 const*>(data);
+
+        uint64 hash = offset_basis;
+        for (size_t i = 0; i < size; ++i)
+        {
+            hash ^= bytes[i];
+            hash *= prime;
+        }
+
+        // FNV-1a's low entropy in the upper bits would cluster the virtual nodes, so finish with a mixer
+        hash ^= hash >> 33;
+        hash *= 0xff51afd7ed558ccdull;
+        hash ^= hash >> 33;
+        return hash;
+    }
+
+    account_service_ring::account_service_ring(size_t virtual_nodes)
+      : virtual_nodes_{std::max<size_t>(virtual_nodes, 1)}
+    {
+    }
+
+    bool account_service_ring::join(std::string const& endpoint,
+                                    std::optional<net::service_locator::located_callback_container> callback)
+    {
+        auto separator = endpoint.rfind(':');
+        if (separator == std::string::npos)
+            return false;
+
+        auto host = endpoint.substr(0, separator);
+        int port = 0;
+        try
+        {
+            port = std::stoi(endpoint.substr(separator + 1));
+        }
+        catch (std::exception const&)
+        {
+            return false;
+        }
+
+        std::unique_lock<std::shared_mutex> lock{mutex_};
+
+        if (nodes_.count(endpoint))
+            return false;
+
+        auto locator = std::make_shared<net::service_locator>();
+        if (callback)
+            locator->locate(account_service_type, host, static_cast<int16_t>(port), *callback);
+        else
+            locator->locate(account_service_type, host, static_cast<int16_t>(port));
+
+        nodes_.emplace(endpoint, std::move(locator));
+
+        for (size_t i = 0; i < virtual_nodes_; ++i)
+        {
+            auto key = endpoint + "#" + std::to_string(i);
+            ring_.emplace(ring_hash(key.data(), key.size()), endpoint);
+        }
+
+        return true;
+    }
+
+    bool account_service_ring::leave(std::string const& endpoint)
+    {
+        std::unique_lock<std::shared_mutex> lock{mutex_};
+
+        if (!nodes_.erase(endpoint))
+            return false;
+
+        for (auto itr = ring_.begin(); itr != ring_.end();)
+        {
+            if (itr->second == endpoint)
+                itr = ring_.erase(itr);
+            else
+                ++itr;
+        }
+
+        return true;
+    }
+
+    account_service_ring::locator_ptr account_service_ring::by_name(std::string const& account_name) const
+    {
+        auto name = to_upper(account_name);
+
+        return find(ring_hash(name.data(), name.size()));
+    }
+
+    account_service_ring::locator_ptr account_service_ring::by_id(uint32 account_id) const
+    {
+        uint8 bytes[] = {static_cast<uint8>(account_id), static_cast<uint8>(account_id >> 8),
+                         static_cast<uint8>(account_id >> 16), static_cast<uint8>(account_id >> 24)};
+
+        return find(ring_hash(bytes, sizeof(bytes)));
+    }
+
+    account_service_ring::locator_ptr account_service_ring::any() const
+    {
+        return find(0);
+    }
+
+    std::vector<std::string> account_service_ring::endpoints() const
+    {
+        std::shared_lock<std::shared_mutex> lock{mutex_};
+
+        std::vector<std::string> endpoints;
+        for (auto const& [endpoint, locator] : nodes_)
+            endpoints.emplace_back(endpoint);
+
+        std::sort(endpoints.begin(), endpoints.end());
+        return endpoints;
+    }
+
+    account_service_ring::locator_ptr account_service_ring::find(uint64 hash) const
+    {
+        std::shared_lock<std::shared_mutex> lock{mutex_};
+
+        if (ring_.empty())
+            return nullptr;
+
+        auto itr = ring_.lower_bound(hash);
+        if (itr == ring_.end())
+            itr = ring_.begin();
+
+        return nodes_.at(itr->second);
+    }
+
+    std::vector<std::string> parse_endpoints(std::string const& endpoints)
+    {
+        std::vector<std::string> result;
+
+        for (auto& endpoint : keycap::root::utility::explode(endpoints, ','))
+        {
+            endpoint.erase(std::remove_if(endpoint.begin(), endpoint.end(),
+                                          [](unsigned char c) { return std::isspace(c); }),
+                           endpoint.end());
+
+            if (!endpoint.empty())
+                result.emplace_back(std::move(endpoint));
+        }
+
+        return result;
+    }
+}
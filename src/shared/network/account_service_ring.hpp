@@ -0,0 +1,84 @@
+/*
+    Copyright 2018-2019 KeycapEmu
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#pragma once
+
+#include <keycap/root/network/service_locator.hpp>
+#include <keycap/root/types.hpp>
+
+#include <map>
+#include <memory>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace keycap::shared::network
+{
+    // Spreads account lookups over multiple accountservers by consistent hashing.
+    // Every accountserver is placed on a hash ring multiple times (virtual nodes); a request is sent to the first
+    // accountserver following the hash of its account name or id. Joining or leaving only moves the keys between the
+    // affected node and its neighbours.
+    // Accountservers aren't told when keys move away from or back to them, so whatever they cache per account may be
+    // outdated by changes made through another accountserver in the meantime. Their character caches are therefore
+    // reloaded after Characters.CacheLifetimeSeconds; cached account ids don't change.
+    class account_service_ring
+    {
+      public:
+        using locator_ptr = std::shared_ptr<keycap::root::network::service_locator>;
+
+        explicit account_service_ring(size_t virtual_nodes = 64);
+
+        // Locates the accountserver at the given endpoint ("host:port") and adds it to the ring. The given callback is
+        // called whenever the accountserver has been (re-)located. Returns false if the endpoint is invalid or has
+        // already joined
+        bool join(std::string const& endpoint,
+                  std::optional<keycap::root::network::service_locator::located_callback_container> callback = {});
+
+        // Removes the accountserver at the given endpoint from the ring. Requests that are still in flight to it are
+        // dropped once nobody holds on to its locator anymore. Returns false if the endpoint hasn't joined
+        bool leave(std::string const& endpoint);
+
+        // Returns the locator of the accountserver that is responsible for the given account name or nullptr if the
+        // ring is empty
+        locator_ptr by_name(std::string const& account_name) const;
+
+        // Returns the locator of the accountserver that is responsible for the given account id or nullptr if the ring
+        // is empty
+        locator_ptr by_id(uint32 account_id) const;
+
+        // Returns the locator of some accountserver for requests that don't belong to any account or nullptr if the
+        // ring is empty
+        locator_ptr any() const;
+
+        // Returns the endpoints of all accountservers on the ring
+        std::vector<std::string> endpoints() const;
+
+      private:
+        locator_ptr find(uint64 hash) const;
+
+        size_t virtual_nodes_;
+
+        mutable std::shared_mutex mutex_;
+        std::unordered_map<std::string, locator_ptr> nodes_;
+        // hash -> endpoint
+        std::map<uint64, std::string> ring_;
+    };
+
+    // Parses a comma separated list of "host:port" endpoints
+    std::vector<std::string> parse_endpoints(std::string const& endpoints);
+}
@@ -0,0 +1,220 @@
+/*
+    Copyright 2018-2019 KeycapEmu
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "ip_ban_list.hpp"
+#include "services.hpp"
+
+#include <generated/shared_protocol.hpp>
+
+#include <keycap/root/utility/utility.hpp>
+
+#include <spdlog/spdlog.h>
+
+#include <boost/lexical_cast.hpp>
+
+namespace keycap::shared::network
+{
+    namespace
+    {
+        bool bit_at(uint8 const* address, size_t index)
+        {
+            return (address[index / 8] >> (7 - index % 8)) & 1;
+        }
+    }
+
+    std::optional<cidr> cidr::parse(std::string const& network)
+    {
+        auto slash = network.find('/');
+
+        boost::system::error_code error;
+        auto address = boost::asio::ip::address::from_string(network.substr(0, slash), error);
+        if (error)
+            return std::nullopt;
+
+        cidr result;
+        result.v6 = address.is_v6();
+
+        if (result.v6)
+        {
+            auto bytes = address.to_v6().to_bytes();
+            std::copy(bytes.begin(), bytes.end(), result.address.begin());
+        }
+        else
+        {
+            auto bytes = address.to_v4().to_bytes();
+            std::copy(bytes.begin(), bytes.end(), result.address.begin());
+        }
+
+        int const max_length = result.v6 ? 128 : 32;
+        int length = max_length;
+
+        if (slash != std::string::npos)
+        {
+            try
+            {
+                length = boost::lexical_cast<int>(network.substr(slash + 1));
+            }
+            catch (boost::bad_lexical_cast const&)
+            {
+                return std::nullopt;
+            }
+        }
+
+        if (length < 0 || length > max_length)
+            return std::nullopt;
+
+        result.prefix_length = static_cast<uint8>(length);
+        return result;
+    }
+
+    void ip_ban_list::trie::insert(uint8 const* address, uint8 prefix_length, rule verdict)
+    {
+        uint32 current = 0;
+        for (size_t i = 0; i < prefix_length; ++i)
+        {
+            auto bit = bit_at(address, i);
+            if (nodes[current].children[bit] == 0)
+            {
+                nodes[current].children[bit] = static_cast<uint32>(nodes.size());
+                nodes.emplace_back();
+            }
+
+            current = nodes[current].children[bit];
+        }
+
+        // Allowing a network takes precedence over banning the very same one
+        if (nodes[current].verdict != rule::allow)
+            nodes[current].verdict = verdict;
+    }
+
+    ip_ban_list::rule ip_ban_list::trie::find(uint8 const* address, uint8 bits) const
+    {
+        auto result = nodes[0].verdict;
+
+        uint32 current = 0;
+        for (size_t i = 0; i < bits; ++i)
+        {
+            current = nodes[current].children[bit_at(address, i)];
+            if (current == 0)
+                break;
+
+            if (nodes[current].verdict != rule::none)
+                result = nodes[current].verdict;
+        }
+
+        return result;
+    }
+
+    ip_ban_list::ip_ban_list()
+      : snapshot_{std::make_shared<snapshot const>()}
+    {
+    }
+
+    size_t ip_ban_list::replace(std::vector<entry> const& entries)
+    {
+        auto next = std::make_shared<snapshot>();
+
+        size_t invalid = 0;
+        for (auto const& entry : entries)
+        {
+            auto network = cidr::parse(entry.network);
+            if (!network)
+            {
+                ++invalid;
+                continue;
+            }
+
+            auto& trie = network->v6 ? next->v6 : next->v4;
+            trie.insert(network->address.data(), network->prefix_length, entry.allow ? rule::allow : rule::ban);
+            ++next->size;
+        }
+
+        std::atomic_store(&snapshot_, std::shared_ptr<snapshot const>{std::move(next)});
+        return invalid;
+    }
+
+    bool ip_ban_list::banned(boost::asio::ip::address const& address) const
+    {
+        auto current = std::atomic_load(&snapshot_);
+        if (current->size == 0)
+            return false;
+
+        rule result = rule::none;
+        if (address.is_v4())
+            result = current->v4.find(address.to_v4().to_bytes().data(), 32);
+        else
+        {
+            auto v6 = address.to_v6();
+
+            // Dual stack sockets report IPv4 clients as ::ffff:a.b.c.d
+            if (v6.is_v4_mapped())
+                result = current->v4.find(v6.to_v4().to_bytes().data(), 32);
+            else
+                result = current->v6.find(v6.to_bytes().data(), 128);
+        }
+
+        if (result != rule::ban)
+            return false;
+
+        ++rejected_;
+        return true;
+    }
+
+    bool ip_ban_list::banned(std::string const& address) const
+    {
+        boost::system::error_code error;
+        auto parsed = boost::asio::ip::address::from_string(address, error);
+        if (error)
+            return false;
+
+        return banned(parsed);
+    }
+
+    size_t ip_ban_list::size() const
+    {
+        return std::atomic_load(&snapshot_)->size;
+    }
+
+    void fetch_ip_bans(keycap::root::network::service_locator& locator, boost::asio::io_service& io_service,
+                       ip_ban_list& ip_bans)
+    {
+        namespace net = keycap::root::network;
+
+        keycap::protocol::request_ip_bans request;
+        locator.send_registered(
+            account_service_type, request.encode(), io_service,
+            [&ip_bans](net::service_type sender, net::memory_stream data) {
+                if (data.peek<keycap::protocol::shared_command>() != keycap::protocol::shared_command::reply_ip_bans)
+                    return false;
+
+                auto reply = keycap::protocol::reply_ip_bans::decode(data);
+
+                std::vector<ip_ban_list::entry> entries;
+                entries.reserve(reply.bans.size());
+                for (auto const& ban : reply.bans)
+                    entries.emplace_back(ip_ban_list::entry{ban.network, ban.allow});
+
+                auto invalid = ip_bans.replace(entries);
+
+                auto console = keycap::root::utility::get_safe_logger("console");
+                console->info("Loaded {} ip ban(s)", ip_bans.size());
+                if (invalid > 0)
+                    console->warn("Skipped {} invalid ip ban(s)", invalid);
+
+                return true;
+            });
+    }
+}
@@ -0,0 +1,123 @@
+/*
+    Copyright 2018-2019 KeycapEmu
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#pragma once
+
+#include <keycap/root/types.hpp>
+
+#include <keycap/root/network/service_locator.hpp>
+
+#include <boost/asio/io_service.hpp>
+#include <boost/asio/ip/address.hpp>
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace keycap::shared::network
+{
+    // A network in CIDR notation like "10.0.0.0/8" or "2001:db8::/32". A plain address is a network of its own
+    struct cidr
+    {
+        // IPv4 networks only use the first 4 bytes
+        std::array<uint8, 16> address{};
+        uint8 prefix_length = 0;
+        bool v6 = false;
+
+        // Returns the network described by the given string or std::nullopt if it's invalid
+        static std::optional<cidr> parse(std::string const& network);
+    };
+
+    // Decides whether connections from an address have to be rejected based on a list of banned and allowed networks.
+    // The most specific matching network wins, so an allowed network may punch a hole into a broader ban.
+    // Lookups walk a binary radix trie in a single immutable snapshot without taking any locks; replacing the list
+    // builds a new snapshot and swaps it in
+    class ip_ban_list
+    {
+      public:
+        struct entry
+        {
+            std::string network;
+            // Exempts the network from broader bans instead of banning it
+            bool allow = false;
+        };
+
+        ip_ban_list();
+
+        // Replaces all networks with the given ones. Returns the number of invalid networks that have been skipped
+        size_t replace(std::vector<entry> const& entries);
+
+        // Returns true if connections from the given address have to be rejected
+        bool banned(boost::asio::ip::address const& address) const;
+
+        // Returns true if connections from the given address have to be rejected. Unparsable addresses aren't banned
+        bool banned(std::string const& address) const;
+
+        // Returns the number of networks in the list
+        size_t size() const;
+
+        // Returns the number of addresses that have been found to be banned
+        uint64 rejected() const
+        {
+            return rejected_;
+        }
+
+      private:
+        enum class rule : uint8
+        {
+            none,
+            ban,
+            allow,
+        };
+
+        struct node
+        {
+            // Indices into trie::nodes. 0 means there's no child as the root can't be anybody's child
+            std::array<uint32, 2> children{};
+            rule verdict = rule::none;
+        };
+
+        struct trie
+        {
+            std::vector<node> nodes{1};
+
+            void insert(uint8 const* address, uint8 prefix_length, rule verdict);
+
+            // Returns the verdict of the longest matching prefix
+            rule find(uint8 const* address, uint8 bits) const;
+        };
+
+        struct snapshot
+        {
+            trie v4;
+            trie v6;
+            size_t size = 0;
+        };
+
+        // Only ever accessed through std::atomic_load/std::atomic_store
+        std::shared_ptr<snapshot const> snapshot_;
+
+        mutable std::atomic_uint64_t rejected_{0};
+    };
+
+    // Asks the accountserver behind the given locator for all active ip bans and replaces the given list's networks
+    // with them once the answer arrives
+    void fetch_ip_bans(keycap::root::network::service_locator& locator, boost::asio::io_service& io_service,
+                       ip_ban_list& ip_bans);
+}
@@ -0,0 +1,113 @@
+/*
+    Copyright 2018-2019 KeycapEmu
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "reuseport_acceptor.hpp"
+
+#include <keycap/root/utility/utility.hpp>
+
+#include <spdlog/spdlog.h>
+
+namespace keycap::shared::network
+{
+    // How long to wait before accepting again after a failed accept
+    constexpr long accept_retry_delay_ms = 100;
+
+#ifdef SO_REUSEPORT
+    using reuse_port = boost::asio::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT>;
+#endif
+
+    bool reuseport_supported()
+    {
+#ifdef SO_REUSEPORT
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    reuseport_acceptor::reuseport_acceptor(accept_callback callback)
+      : acceptor_{io_service_}
+      , socket_{io_service_}
+      , retry_timer_{io_service_}
+      , callback_{std::move(callback)}
+    {
+    }
+
+    reuseport_acceptor::~reuseport_acceptor()
+    {
+        stop();
+    }
+
+    void reuseport_acceptor::start(std::string const& host, uint16 port)
+    {
+        boost::asio::ip::tcp::endpoint endpoint{boost::asio::ip::address::from_string(host), port};
+
+        acceptor_.open(endpoint.protocol());
+        acceptor_.set_option(boost::asio::ip::tcp::acceptor::reuse_address{true});
+#ifdef SO_REUSEPORT
+        acceptor_.set_option(reuse_port{true});
+#endif
+        acceptor_.bind(endpoint);
+        acceptor_.listen();
+
+        accept();
+
+        work_.emplace(io_service_);
+        thread_ = std::thread{[this] { io_service_.run(); }};
+    }
+
+    void reuseport_acceptor::stop()
+    {
+        if (!thread_.joinable())
+            return;
+
+        boost::system::error_code ignored;
+        acceptor_.close(ignored);
+        retry_timer_.cancel(ignored);
+
+        work_.reset();
+        io_service_.stop();
+        thread_.join();
+    }
+
+    void reuseport_acceptor::accept()
+    {
+        acceptor_.async_accept(socket_, [this](boost::system::error_code const& error) {
+            if (error == boost::asio::error::operation_aborted)
+                return;
+
+            if (error)
+            {
+                auto logger = keycap::root::utility::get_safe_logger("connections");
+                logger->error("[reuseport_acceptor] Failed to accept a connection: {}", error.message());
+
+                socket_ = boost::asio::ip::tcp::socket{io_service_};
+                retry_timer_.expires_from_now(boost::posix_time::milliseconds{accept_retry_delay_ms});
+                retry_timer_.async_wait([this](boost::system::error_code const& error) {
+                    if (!error)
+                        accept();
+                });
+                return;
+            }
+
+            callback_(std::move(socket_));
+
+            // A moved-from socket may be reused for the next connection
+            socket_ = boost::asio::ip::tcp::socket{io_service_};
+            accept();
+        });
+    }
+}
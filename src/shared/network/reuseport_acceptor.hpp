@@ -0,0 +1,124 @@
+/*
+    Copyright 2018-2019 KeycapEmu
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#pragma once
+
+#include <keycap/root/types.hpp>
+
+#include <boost/asio.hpp>
+
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace keycap::shared::network
+{
+    // Returns true if the platform allows multiple sockets to listen on the same endpoint using SO_REUSEPORT
+    bool reuseport_supported();
+
+    // A listener bound with SO_REUSEPORT that owns its own io_service and thread.
+    // Any number of them may listen on the same endpoint; the kernel spreads new connections across them, so bursts of
+    // connections don't queue up behind a single acceptor and every connection stays on the thread that accepted it
+    class reuseport_acceptor
+    {
+      public:
+        // Called on the acceptor's thread for every accepted socket. The socket belongs to the acceptor's io_service
+        using accept_callback = std::function<void(boost::asio::ip::tcp::socket socket)>;
+
+        explicit reuseport_acceptor(accept_callback callback);
+
+        ~reuseport_acceptor();
+
+        reuseport_acceptor(reuseport_acceptor const&) = delete;
+        reuseport_acceptor& operator=(reuseport_acceptor const&) = delete;
+
+        // Binds to the given endpoint and starts accepting on a new thread. Throws boost::system::system_error if the
+        // endpoint can't be bound
+        void start(std::string const& host, uint16 port);
+
+        // Stops accepting and stops the io_service, including all connections running on it
+        void stop();
+
+      private:
+        void accept();
+
+        boost::asio::io_service io_service_;
+        std::optional<boost::asio::io_service::work> work_;
+
+        boost::asio::ip::tcp::acceptor acceptor_;
+        boost::asio::ip::tcp::socket socket_;
+        // Delays the next accept after a failed one. Errors like running out of file descriptors don't go away by
+        // retrying right away
+        boost::asio::deadline_timer retry_timer_;
+
+        accept_callback callback_;
+
+        std::thread thread_;
+    };
+
+    // Serves a service's connections from one reuseport_acceptor per thread instead of the service's own acceptor and
+    // io_service. SERVICE must provide make_handler and on_new_connection like keycap::root::network::service
+    template <typename SERVICE>
+    class reuseport_server
+    {
+      public:
+        explicit reuseport_server(SERVICE& service)
+          : service_{service}
+        {
+        }
+
+        ~reuseport_server()
+        {
+            stop();
+        }
+
+        // Starts the given number of acceptors on the given endpoint
+        void start(std::string const& host, uint16 port, int threads)
+        {
+            for (int i = 0; i < threads; ++i)
+            {
+                auto acceptor = std::make_unique<reuseport_acceptor>([this](boost::asio::ip::tcp::socket socket) {
+                    auto handler = service_.make_handler(std::move(socket));
+                    if (service_.on_new_connection(handler))
+                        handler->listen();
+                });
+
+                acceptor->start(host, port);
+                acceptors_.push_back(std::move(acceptor));
+            }
+        }
+
+        void stop()
+        {
+            for (auto& acceptor : acceptors_)
+                acceptor->stop();
+
+            acceptors_.clear();
+        }
+
+        bool running() const
+        {
+            return !acceptors_.empty();
+        }
+
+      private:
+        SERVICE& service_;
+        std::vector<std::unique_ptr<reuseport_acceptor>> acceptors_;
+    };
+}
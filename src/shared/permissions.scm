@@ -6,4 +6,11 @@ enum permission : dword
     CommandShutdown = 201,
     CommandAccount = 202,
     CommandAccountCreate = 203,
+    CommandAccountSeed = 204,
+    CommandCrypto = 205,
+    CommandAdmission = 206,
+    CommandLatency = 207,
+    CommandAccountServices = 208,
+    CommandIpBans = 209,
+    CommandDatabase = 210,
 }
\ No newline at end of file
@@ -0,0 +1,114 @@
+/*
+    Copyright 2018-2019 KeycapEmu
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+// Known answer test for keycap::shared::cryptography::srp6. The expected values have been computed independently from
+// the compliance::Wow wire format and are cross-checked against keycap::root::network::srp6
+#include <cryptography/srp6.hpp>
+
+#include <keycap/root/network/srp6/server.hpp>
+#include <keycap/root/network/srp6/utility.hpp>
+
+#include <botan/numthry.h>
+
+#include <iostream>
+
+namespace net = keycap::root::network;
+namespace srp6 = keycap::shared::cryptography::srp6;
+
+namespace
+{
+    int failures = 0;
+
+    void expect(bool condition, char const* what)
+    {
+        if (condition)
+            return;
+
+        std::cerr << "srp6: " << what << " mismatch\n";
+        ++failures;
+    }
+
+    Botan::BigInt hex(char const* value)
+    {
+        return Botan::BigInt{std::string{"0x"} + value};
+    }
+}
+
+int main()
+{
+    std::string const username = "TEST";
+    std::string const password = "TEST";
+
+    auto const N = hex("894B645E89E1535BBDAD5B8B290650530801B18EBFBF5E8FAB3C82872A3E9BB7");
+    Botan::BigInt const g{7};
+    auto const salt = hex("B0B1B2B3B4B5B6B7B8B9BABBBCBDBEBFC0C1C2C3C4C5C6C7C8C9CACBCCCDCECF");
+    auto const a = hex("0102030405060708090A0B0C0D0E0F101112131415161718191A1B1C1D1E1F20");
+    auto const b = hex("A1A2A3A4A5A6A7A8A9AAABACADAEAFB0B1B2B3B4B5B6B7B8B9BABBBCBDBEBFC0");
+
+    auto const x = hex("53F242FAC999FF67A5D30EF7919453EF36FA2ACB");
+    auto const v = hex("2E9DA314569A06601A7EAE847E7BADFECA00DF00484E17C037BA8854E2C642D6");
+    auto const A = hex("705A116293F35D0E2B97ABA4FBE288F12EC1851A967E3DEDF7173AE52AC9AA39");
+    auto const B = hex("4D69D782AB7BA9271BC86728B657D553D793158048705BDD52D4F74F0DA06253");
+    auto const u = hex("D6F8B3A200210099D451CA3BA25329126A559EF2");
+    auto const K = hex("F5BC0B1EF779A6D8471F593FB00681B2BB7DF0614DC9A9F7D83748DACCD4F8985A3C7FA38F9B5EF9");
+    auto const M1 = hex("481614EE80A799526D674994774AB4D0985B435A");
+    auto const M2 = hex("74418E77CB2CF4FEEC20B806A17D7B725FD5C769");
+
+    // Wire format round trip
+    auto wire = srp6::to_little_endian(A, 32);
+    expect(wire.front() == 0x39 && wire.back() == 0x70, "to_little_endian");
+    expect(srp6::from_little_endian(wire.data(), wire.size()) == A, "from_little_endian");
+
+    // Building blocks
+    expect(srp6::private_key(username, password, salt) == x, "x");
+    expect(Botan::power_mod(g, x, N) == v, "v");
+    expect(Botan::power_mod(g, a, N) == A, "A");
+    expect(srp6::scrambler(A, B) == u, "u");
+    expect(srp6::client_session_key(N, g, B, a, A, x) == K, "client K");
+    expect(srp6::server_session_key(N, v, A, b, B) == K, "server K");
+    expect(srp6::client_proof(N, g, salt, username, A, B, K) == M1, "M1");
+    expect(srp6::server_proof(A, M1, K) == M2, "M2");
+
+    // The server with a precomputed ephemeral
+    srp6::server server{N, g, v, srp6::ephemeral{b, Botan::power_mod(g, b, N)}};
+    expect(server.public_ephemeral_value() == B, "server B");
+    expect(server.session_key(A) == K, "server session_key");
+    expect(server.proof(M1, K) == M2, "server proof");
+    expect(server.session_key(N * 2).is_zero(), "server rejects A % N == 0");
+
+    // keycap::root::network::srp6 must agree for the same N, g, v and A. Its server draws b on its own, so the client
+    // side of the handshake is computed against the B it hands out
+    constexpr auto compliance = net::srp6::compliance::Wow;
+    auto parameter = net::srp6::get_parameters(net::srp6::group_parameters::_256);
+    expect(Botan::BigInt{parameter.N} == N && Botan::BigInt{parameter.g} == g, "root group parameters");
+    expect(net::srp6::generate_verifier(username, password, parameter, salt, compliance) == v, "root v");
+    expect(net::srp6::generate_client_proof(N, g, salt, username, A, B, K, compliance) == M1, "root M1");
+
+    net::srp6::server root_server{parameter, v, compliance};
+    auto root_B = root_server.public_ephemeral_value();
+    auto root_K = srp6::client_session_key(N, g, root_B, a, A, x);
+    expect(root_server.session_key(A) == root_K, "root session_key");
+
+    auto root_M1 = srp6::client_proof(N, g, salt, username, A, root_B, root_K);
+    expect(net::srp6::generate_client_proof(N, g, salt, username, A, root_B, root_K, compliance) == root_M1,
+           "root client proof");
+    expect(root_server.proof(root_M1, root_K) == srp6::server_proof(A, root_M1, root_K), "root server proof");
+
+    if (failures == 0)
+        std::cout << "srp6: all known answers match\n";
+
+    return failures == 0 ? 0 : 1;
+}
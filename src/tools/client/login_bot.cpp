@@ -0,0 +1,282 @@
+/*
+    Copyright 2018-2019 KeycapEmu
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "login_bot.hpp"
+
+#include <cryptography/random.hpp>
+#include <cryptography/srp6.hpp>
+#include <string_utility.hpp>
+
+#include <botan/numthry.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace srp6 = keycap::shared::cryptography::srp6;
+
+namespace keycap::client
+{
+    // Command bytes of the logon protocol. See logonserver/protocol/logon.msg
+    constexpr uint8 command_challange = 0;
+    constexpr uint8 command_proof = 1;
+    constexpr uint8 command_realm_list = 16;
+    constexpr uint8 command_xfer_initiate = 48;
+    constexpr uint8 command_xfer_cancel = 52;
+
+    constexpr uint8 security_flag_pin = 1;
+    constexpr uint8 security_flag_matrix = 2;
+    constexpr uint8 security_flag_token = 4;
+
+    // cmd + protocol_version + error
+    constexpr size_t challange_header_size = 3;
+    // B, g_length, g, N_length, N, s, checksum_salt, security_flags
+    constexpr size_t challange_body_size = 32 + 1 + 1 + 1 + 32 + 32 + 16 + 1;
+    // cmd + error
+    constexpr size_t proof_header_size = 2;
+    // M2, account_flags, survey_id, num_account_messages
+    constexpr size_t proof_body_size = 20 + 4 + 4 + 2;
+    // cmd + action length
+    constexpr size_t transfer_header_size = 2;
+    // cmd + size
+    constexpr size_t realm_list_header_size = 3;
+
+    template <typename T>
+    void append(std::vector<uint8>& buffer, T value)
+    {
+        auto begin = reinterpret_cast<uint8 const*>(&value);
+        buffer.insert(buffer.end(), begin, begin + sizeof(T));
+    }
+
+    void append(std::vector<uint8>& buffer, std::vector<uint8> const& data)
+    {
+        buffer.insert(buffer.end(), data.begin(), data.end());
+    }
+
+    login_bot::login_bot(boost::asio::io_service& io_service, login_target target, login_statistics& statistics)
+      : socket_{io_service}
+      , target_{std::move(target)}
+      , statistics_{statistics}
+    {
+        target_.account_name = shared::to_upper(std::move(target_.account_name));
+    }
+
+    void login_bot::run(done_callback callback)
+    {
+        callback_ = std::move(callback);
+        started_ = phase_started_ = clock::now();
+
+        socket_.async_connect(target_.endpoint,
+                              [self = shared_from_this()](auto const& error) { self->on_connected(error); });
+    }
+
+    void login_bot::on_connected(boost::system::error_code const& error)
+    {
+        if (error)
+            return finish(false, &statistics_.connect_failures);
+
+        socket_.set_option(boost::asio::ip::tcp::no_delay{true});
+        statistics_.connect.record(clock::now() - phase_started_);
+        send_challange();
+    }
+
+    void login_bot::send_challange()
+    {
+        auto const& name = target_.account_name;
+
+        std::vector<uint8> packet;
+        packet.reserve(34 + name.size());
+        append<uint8>(packet, command_challange);
+        append<uint8>(packet, 8);
+        append<uint16>(packet, static_cast<uint16>(30 + name.size()));
+        append(packet, std::vector<uint8>{'W', 'o', 'W', 0});
+        append(packet, std::vector<uint8>{1, 12, 1});
+        append<uint16>(packet, target_.build);
+        append(packet, std::vector<uint8>{'6', '8', 'x', 0});
+        append(packet, std::vector<uint8>{'n', 'i', 'W', 0});
+        append(packet, std::vector<uint8>{'S', 'U', 'n', 'e'});
+        append<uint32>(packet, 60);
+        append(packet, std::vector<uint8>{127, 0, 0, 1});
+        append<uint8>(packet, static_cast<uint8>(name.size()));
+        packet.insert(packet.end(), name.begin(), name.end());
+
+        phase_started_ = clock::now();
+        write(std::move(packet), [this] { read(challange_header_size, &login_bot::on_challange_header); });
+    }
+
+    void login_bot::on_challange_header(boost::system::error_code const& error)
+    {
+        if (error || buffer_[0] != command_challange || buffer_[2] != 0)
+            return finish(false, &statistics_.challange_failures);
+
+        read(challange_body_size, &login_bot::on_challange_body);
+    }
+
+    void login_bot::on_challange_body(boost::system::error_code const& error)
+    {
+        if (error)
+            return finish(false, &statistics_.challange_failures);
+
+        auto data = buffer_.data();
+        auto B = srp6::from_little_endian(data, 32);
+        Botan::BigInt g{data[33]};
+        auto N = srp6::from_little_endian(data + 35, 32);
+        auto salt = srp6::from_little_endian(data + 67, 32);
+        auto security_flags = data[challange_body_size - 1];
+
+        // The bots only support plain password authentication
+        if (security_flags & (security_flag_pin | security_flag_matrix | security_flag_token))
+            return finish(false, &statistics_.challange_failures);
+
+        statistics_.challange.record(clock::now() - phase_started_);
+
+        a_ = Botan::BigInt{shared::cryptography::thread_rng(), 19 * 8};
+        A_ = Botan::power_mod(g, a_, N);
+
+        auto x = srp6::private_key(target_.account_name, target_.password, salt);
+        session_key_ = srp6::client_session_key(N, g, B, a_, A_, x);
+
+        auto M1 = srp6::client_proof(N, g, salt, target_.account_name, A_, B, session_key_);
+
+        std::vector<uint8> packet;
+        packet.reserve(75);
+        append<uint8>(packet, command_proof);
+        append(packet, srp6::to_little_endian(A_, 32));
+        append(packet, srp6::to_little_endian(M1, 20));
+        packet.resize(packet.size() + 20, 0); // checksum
+        append<uint8>(packet, 0);             // number of telemetry_data
+        append<uint8>(packet, 0);             // security_flags
+
+        // M2 will be checked against the expected server proof once it arrives
+        expected_M2_ = srp6::to_little_endian(srp6::server_proof(A_, M1, session_key_), 20);
+
+        phase_started_ = clock::now();
+        write(std::move(packet), [this] { read(proof_header_size, &login_bot::on_proof_header); });
+    }
+
+    void login_bot::on_proof_header(boost::system::error_code const& error)
+    {
+        if (error || buffer_[0] != command_proof || buffer_[1] != 0)
+            return finish(false, &statistics_.proof_failures);
+
+        read(proof_body_size, &login_bot::on_proof_body);
+    }
+
+    void login_bot::on_proof_body(boost::system::error_code const& error)
+    {
+        if (error || !std::equal(expected_M2_.begin(), expected_M2_.end(), buffer_.begin()))
+            return finish(false, &statistics_.proof_failures);
+
+        std::memcpy(&survey_id_, buffer_.data() + 24, sizeof(survey_id_));
+        statistics_.proof.record(clock::now() - phase_started_);
+
+        if (survey_id_ != 0)
+            return read(transfer_header_size, &login_bot::on_transfer_header);
+
+        send_realm_list();
+    }
+
+    void login_bot::on_transfer_header(boost::system::error_code const& error)
+    {
+        if (error || buffer_[0] != command_xfer_initiate)
+            return finish(false, &statistics_.proof_failures);
+
+        // action, filesize, md5_checksum
+        read(buffer_[1] + sizeof(uint64) + 16, &login_bot::on_transfer_body);
+    }
+
+    void login_bot::on_transfer_body(boost::system::error_code const& error)
+    {
+        if (error)
+            return finish(false, &statistics_.proof_failures);
+
+        // Behave like a client that already has the survey and skip the download
+        write({command_xfer_cancel}, [this] { send_realm_list(); });
+    }
+
+    void login_bot::send_realm_list()
+    {
+        std::vector<uint8> packet;
+        append<uint8>(packet, command_realm_list);
+        append<uint32>(packet, 0);
+
+        phase_started_ = clock::now();
+        write(std::move(packet), [this] { read(realm_list_header_size, &login_bot::on_realm_list_header); });
+    }
+
+    void login_bot::on_realm_list_header(boost::system::error_code const& error)
+    {
+        if (error || buffer_[0] != command_realm_list)
+            return finish(false, &statistics_.realm_list_failures);
+
+        uint16 size = 0;
+        std::memcpy(&size, buffer_.data() + 1, sizeof(size));
+        read(size, &login_bot::on_realm_list_body);
+    }
+
+    void login_bot::on_realm_list_body(boost::system::error_code const& error)
+    {
+        if (error)
+            return finish(false, &statistics_.realm_list_failures);
+
+        auto now = clock::now();
+        statistics_.realm_list.record(now - phase_started_);
+        statistics_.total.record(now - started_);
+        ++statistics_.logins;
+
+        finish(true);
+    }
+
+    void login_bot::write(std::vector<uint8> buffer, std::function<void()> callback)
+    {
+        auto data = std::make_shared<std::vector<uint8>>(std::move(buffer));
+
+        boost::asio::async_write(
+            socket_, boost::asio::buffer(*data),
+            [self = shared_from_this(), data, callback = std::move(callback)](auto const& error, size_t) {
+                if (error)
+                    return self->finish(false);
+
+                callback();
+            });
+    }
+
+    void login_bot::read(size_t size, void (login_bot::*handler)(boost::system::error_code const&))
+    {
+        buffer_.resize(size);
+
+        boost::asio::async_read(socket_, boost::asio::buffer(buffer_),
+                                [self = shared_from_this(), handler](auto const& error, size_t) {
+                                    (self.get()->*handler)(error);
+                                });
+    }
+
+    void login_bot::finish(bool success, std::atomic_uint64_t* failure_counter)
+    {
+        if (failure_counter)
+            ++*failure_counter;
+
+        boost::system::error_code ignored;
+        socket_.shutdown(boost::asio::ip::tcp::socket::shutdown_both, ignored);
+        socket_.close(ignored);
+
+        if (callback_)
+        {
+            auto callback = std::move(callback_);
+            callback_ = nullptr;
+            callback(success);
+        }
+    }
+}
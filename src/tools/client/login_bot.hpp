@@ -0,0 +1,115 @@
+/*
+    Copyright 2018-2019 KeycapEmu
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#pragma once
+
+#include <metrics/latency_histogram.hpp>
+
+#include <keycap/root/types.hpp>
+
+#include <botan/bigint.h>
+
+#include <boost/asio.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace keycap::client
+{
+    // Everything the login_bots report back to the load generator
+    struct login_statistics
+    {
+        shared::metrics::latency_histogram connect;
+        shared::metrics::latency_histogram challange;
+        shared::metrics::latency_histogram proof;
+        shared::metrics::latency_histogram realm_list;
+        shared::metrics::latency_histogram total;
+
+        std::atomic_uint64_t logins{0};
+        std::atomic_uint64_t connect_failures{0};
+        std::atomic_uint64_t challange_failures{0};
+        std::atomic_uint64_t proof_failures{0};
+        std::atomic_uint64_t realm_list_failures{0};
+    };
+
+    struct login_target
+    {
+        boost::asio::ip::tcp::endpoint endpoint;
+        std::string account_name;
+        std::string password;
+        uint16 build = 5875;
+    };
+
+    // Drives a single headless client through the logon sequence:
+    // connect -> client_logon_challange -> client_logon_proof -> client_realm_list
+    class login_bot : public std::enable_shared_from_this<login_bot>
+    {
+        using clock = std::chrono::steady_clock;
+
+      public:
+        // Will be called once the login sequence has finished. `success` is false if any of the phases failed
+        using done_callback = std::function<void(bool success)>;
+
+        login_bot(boost::asio::io_service& io_service, login_target target, login_statistics& statistics);
+
+        // Starts the login sequence and calls the given callback once it has finished
+        void run(done_callback callback);
+
+      private:
+        void on_connected(boost::system::error_code const& error);
+
+        void send_challange();
+        void on_challange_header(boost::system::error_code const& error);
+        void on_challange_body(boost::system::error_code const& error);
+
+        void on_proof_header(boost::system::error_code const& error);
+        void on_proof_body(boost::system::error_code const& error);
+        void on_transfer_header(boost::system::error_code const& error);
+        void on_transfer_body(boost::system::error_code const& error);
+
+        void send_realm_list();
+        void on_realm_list_header(boost::system::error_code const& error);
+        void on_realm_list_body(boost::system::error_code const& error);
+
+        // Writes the given buffer to the socket and calls the given callback once it has been written
+        void write(std::vector<uint8> buffer, std::function<void()> callback);
+
+        // Reads exactly `size` bytes into buffer_ and calls the given handler afterwards
+        void read(size_t size, void (login_bot::*handler)(boost::system::error_code const&));
+
+        void finish(bool success, std::atomic_uint64_t* failure_counter = nullptr);
+
+        boost::asio::ip::tcp::socket socket_;
+        login_target target_;
+        login_statistics& statistics_;
+        done_callback callback_;
+
+        std::vector<uint8> buffer_;
+        std::vector<uint8> expected_M2_;
+
+        Botan::BigInt a_;
+        Botan::BigInt A_;
+        Botan::BigInt session_key_;
+        uint32 survey_id_ = 0;
+
+        clock::time_point started_;
+        clock::time_point phase_started_;
+    };
+}
@@ -14,7 +14,160 @@
     limitations under the License.
 */
 
-int main()
+#include "login_bot.hpp"
+
+#include <keycap/root/configuration/config_file.hpp>
+
+#include <spdlog/fmt/fmt.h>
+
+#include <boost/asio.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace client = keycap::client;
+
+struct config
+{
+    struct
+    {
+        std::string host;
+        uint16 port;
+        int threads;
+        int connections;
+        int duration;
+    } network;
+
+    struct
+    {
+        std::string prefix;
+        int count;
+        std::string password;
+        uint16 build;
+    } accounts;
+};
+
+config parse_config(std::string config_file)
+{
+    keycap::root::configuration::config_file cfg_file{config_file};
+
+    config conf;
+    conf.network.host = cfg_file.get_or_default<std::string>("Network", "Host", "127.0.0.1");
+    conf.network.port = cfg_file.get_or_default<uint16>("Network", "Port", 3724);
+    conf.network.threads = cfg_file.get_or_default<int>("Network", "Threads", 1);
+    conf.network.connections = cfg_file.get_or_default<int>("Network", "Connections", 100);
+    conf.network.duration = cfg_file.get_or_default<int>("Network", "Duration", 60);
+
+    conf.accounts.prefix = cfg_file.get_or_default<std::string>("Accounts", "Prefix", "BOT");
+    conf.accounts.count = cfg_file.get_or_default<int>("Accounts", "Count", 1000);
+    conf.accounts.password = cfg_file.get_or_default<std::string>("Accounts", "Password", "BOT");
+    conf.accounts.build = cfg_file.get_or_default<uint16>("Accounts", "Build", 5875);
+
+    return conf;
+}
+
+// Keeps the configured number of login_bots running until the deadline has been reached
+class load_generator
+{
+    using clock = std::chrono::steady_clock;
+
+  public:
+    load_generator(config const& config, boost::asio::ip::tcp::endpoint endpoint, client::login_statistics& statistics)
+      : config_{config}
+      , endpoint_{endpoint}
+      , statistics_{statistics}
+      , deadline_{clock::now() + std::chrono::seconds{config.network.duration}}
+    {
+    }
+
+    // Starts a new login on the given io_service as long as the deadline hasn't been reached
+    void start_login(boost::asio::io_service& io_service)
+    {
+        if (clock::now() >= deadline_)
+            return;
+
+        auto index = next_account_++ % config_.accounts.count;
+
+        client::login_target target;
+        target.endpoint = endpoint_;
+        target.account_name = fmt::format("{}{}", config_.accounts.prefix, index);
+        target.password = config_.accounts.password;
+        target.build = config_.accounts.build;
+
+        auto bot = std::make_shared<client::login_bot>(io_service, std::move(target), statistics_);
+        bot->run([this, &io_service](bool) { start_login(io_service); });
+    }
+
+  private:
+    config const& config_;
+    boost::asio::ip::tcp::endpoint endpoint_;
+    client::login_statistics& statistics_;
+    clock::time_point deadline_;
+    std::atomic_uint64_t next_account_{0};
+};
+
+void print_statistics(client::login_statistics const& statistics)
+{
+    std::cout << fmt::format("connect:    {}\n", statistics.connect.summary());
+    std::cout << fmt::format("challange:  {}\n", statistics.challange.summary());
+    std::cout << fmt::format("proof:      {}\n", statistics.proof.summary());
+    std::cout << fmt::format("realm_list: {}\n", statistics.realm_list.summary());
+    std::cout << fmt::format("total:      {}\n", statistics.total.summary());
+    std::cout << fmt::format("failures: connect={} challange={} proof={} realm_list={}\n",
+                             statistics.connect_failures.load(), statistics.challange_failures.load(),
+                             statistics.proof_failures.load(), statistics.realm_list_failures.load());
+}
+
+// Usage: client [config file]
+// Hammers the logonserver with full SRP6 logins and reports logins/sec and per-phase latency percentiles.
+// The accounts can be created with the accountserver's "account seed <prefix> <count> <password>" command.
+int main(int argc, char* argv[])
 {
+    auto config = parse_config(argc > 1 ? argv[1] : "client.json");
+
+    boost::asio::ip::tcp::endpoint endpoint{boost::asio::ip::address::from_string(config.network.host),
+                                            config.network.port};
+
+    client::login_statistics statistics;
+    load_generator generator{config, endpoint, statistics};
+
+    auto thread_count = std::max(config.network.threads, 1);
+    std::vector<std::unique_ptr<boost::asio::io_service>> io_services;
+    for (int i = 0; i < thread_count; ++i)
+        io_services.emplace_back(std::make_unique<boost::asio::io_service>());
+
+    for (int i = 0; i < config.network.connections; ++i)
+        generator.start_login(*io_services[i % thread_count]);
+
+    std::vector<std::thread> threads;
+    for (auto& io_service : io_services)
+        threads.emplace_back([&io_service] { io_service->run(); });
+
+    std::atomic_bool running{true};
+    std::thread reporter{[&] {
+        uint64_t last_logins = 0;
+        int elapsed = 0;
+        while (running)
+        {
+            std::this_thread::sleep_for(std::chrono::seconds{1});
+            auto logins = statistics.logins.load();
+            std::cout << fmt::format("[{:>4}s] {} logins/sec ({} total)\n", ++elapsed, logins - last_logins, logins);
+            last_logins = logins;
+        }
+    }};
+
+    for (auto& thread : threads)
+        thread.join();
+
+    running = false;
+    reporter.join();
 
-}
\ No newline at end of file
+    auto logins = statistics.logins.load();
+    std::cout << fmt::format("\n{} logins in {}s ({:.1f} logins/sec)\n", logins, config.network.duration,
+                             static_cast<double>(logins) / std::max(config.network.duration, 1));
+    print_statistics(statistics);
+}
@@ -0,0 +1,72 @@
+/*
+    Copyright 2018-2019 KeycapEmu
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <cryptography/random.hpp>
+
+#include <botan/auto_rng.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace cryptography = keycap::shared::cryptography;
+
+// Runs the given function `iterations` times on each of `threads` threads and returns the mean time per call in ns
+double benchmark(size_t threads, size_t iterations, std::function<void()> const& function)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> workers;
+    for (size_t i = 0; i < threads; ++i)
+    {
+        workers.emplace_back([&] {
+            for (size_t j = 0; j < iterations; ++j)
+                function();
+        });
+    }
+
+    for (auto& worker : workers)
+        worker.join();
+
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / iterations;
+}
+
+// Compares constructing a Botan::AutoSeeded_RNG per request (what the servers used to do for every login) with the
+// thread local buffered DRBG.
+// Usage: rng_benchmark [threads] [iterations] [request size]
+int main(int argc, char* argv[])
+{
+    size_t threads = argc > 1 ? std::stoul(argv[1]) : 4;
+    size_t iterations = argc > 2 ? std::stoul(argv[2]) : 100000;
+    size_t size = argc > 3 ? std::stoul(argv[3]) : 16;
+
+    std::cout << "Requesting " << size << " bytes " << iterations << " times on " << threads << " thread(s)\n";
+
+    auto auto_seeded = benchmark(threads, iterations, [size] { Botan::AutoSeeded_RNG().random_vec(size); });
+    std::cout << "AutoSeeded_RNG per request: " << auto_seeded << " ns/request\n";
+
+    auto buffered = benchmark(threads, iterations, [size] { cryptography::random_bytes(size); });
+    std::cout << "thread_rng:                 " << buffered << " ns/request\n";
+
+    std::cout << "Speedup: " << auto_seeded / buffered << "x\n";
+
+    return EXIT_SUCCESS;
+}